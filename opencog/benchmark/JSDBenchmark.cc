@@ -0,0 +1,117 @@
+/*
+ * JSDBenchmark.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Compare the Jensen-Shannon distance kernel of Surprisingness::jsd
+// against the former implementation, evaluating the cdfs of both beta
+// distributions on every bin then calling kld twice.
+//
+// Usage: jsd-benchmark [PAIRS [DISTINCT_TVS [BINS]]]
+//
+// PAIRS pairs of TVs are drawn from a pool of DISTINCT_TVS TVs, to
+// mimic estimates shared across patterns. Results are printed in CSV
+// format, one line per run.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include <opencog/util/random.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
+#include <opencog/ure/BetaDistribution.h>
+#include <opencog/miner/Surprisingness.h>
+
+using namespace opencog;
+
+// Former implementation of Surprisingness::jsd
+static double jsd_ref(TruthValuePtr l_tv, TruthValuePtr r_tv, unsigned bins)
+{
+	BetaDistribution l_bd(l_tv);
+	BetaDistribution r_bd(r_tv);
+	std::vector<double>
+		l_cdf = l_bd.cdf(bins),
+		r_cdf = r_bd.cdf(bins),
+		m_cdf = Surprisingness::avrg_cdf(l_cdf, r_cdf);
+	double
+		ld = Surprisingness::kld(l_cdf, m_cdf),
+		rd = Surprisingness::kld(r_cdf, m_cdf);
+	return sqrt(Surprisingness::avrg(ld, rd));
+}
+
+template<typename F>
+static double time_pairs(const TruthValueSeq& tvs,
+                         const std::vector<std::pair<unsigned, unsigned>>& pairs,
+                         F jsd, std::vector<double>& results)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < pairs.size(); i++)
+		results[i] = jsd(tvs[pairs[i].first], tvs[pairs[i].second]);
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+	unsigned n_pairs = 1 < argc ? std::stoul(argv[1]) : 10000;
+	unsigned n_tvs = 2 < argc ? std::stoul(argv[2]) : 1000;
+	unsigned bins = 3 < argc ? std::stoul(argv[3]) : 100;
+
+	randGen().seed(0);
+
+	// Generate the TV pool, with counts ranging from 1 to 10^6
+	TruthValueSeq tvs;
+	for (unsigned i = 0; i < n_tvs; i++) {
+		double count = std::pow(10.0, 6.0 * randGen().randdouble());
+		double strength = randGen().randdouble();
+		tvs.push_back(createSimpleTruthValue(
+			              strength, Surprisingness::count_to_confidence(count)));
+	}
+	std::vector<std::pair<unsigned, unsigned>> pairs;
+	for (unsigned i = 0; i < n_pairs; i++)
+		pairs.emplace_back(randGen().randint(n_tvs), randGen().randint(n_tvs));
+
+	std::vector<double> ref_res(n_pairs), cold_res(n_pairs), warm_res(n_pairs);
+	auto ref = [&](TruthValuePtr l, TruthValuePtr r) {
+		return jsd_ref(l, r, bins); };
+	auto kernel = [&](TruthValuePtr l, TruthValuePtr r) {
+		return Surprisingness::jsd(l, r, bins); };
+	double ref_time = time_pairs(tvs, pairs, ref, ref_res);
+	double cold_time = time_pairs(tvs, pairs, kernel, cold_res);
+	double warm_time = time_pairs(tvs, pairs, kernel, warm_res);
+
+	double max_err = 0.0;
+	for (unsigned i = 0; i < n_pairs; i++)
+		max_err = std::max(max_err, std::fabs(ref_res[i] - cold_res[i]));
+
+	std::cout << "name,pairs,distinct_tvs,bins,seconds,speedup,max_abs_error"
+	          << std::endl;
+	auto report = [&](const std::string& name, double t) {
+		std::cout << name << "," << n_pairs << "," << n_tvs << "," << bins
+		          << "," << t << "," << ref_time / t << "," << max_err
+		          << std::endl;
+	};
+	report("jsd_ref", ref_time);
+	report("jsd_cold_cache", cold_time);
+	report("jsd_warm_cache", warm_time);
+
+	return 0;
+}
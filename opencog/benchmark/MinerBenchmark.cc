@@ -0,0 +1,217 @@
+/*
+ * MinerBenchmark.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+// Microbenchmarks of the hot functions of MinerUtils, Valuations and
+// Surprisingness, over synthetic dbs of various sizes and patterns of
+// various shapes, to track performance regressions.
+//
+// Usage: miner-benchmark [DB_SIZES [ITERATIONS [FILTER]]]
+//
+// DB_SIZES is a comma separated list of db sizes, each db made of
+// that many data trees
+//
+// (Inheritance (Concept "A<i>") (Concept "B<j>"))
+//
+// with i drawn among db size / 10 and j among 10 values. The shapes
+// of patterns are
+//
+// unary: (Inheritance X (Concept "B0"))
+// binary: (Inheritance X Y)
+// star2: (Inheritance X Y) (Inheritance X Z)
+// star3: (Inheritance X Y) (Inheritance X Z) (Inheritance X W)
+//
+// Each benchmark runs ITERATIONS times, only the benchmarks whose
+// names contain FILTER, if any. Results are printed in CSV format,
+// one line per benchmark, shape and db size, with a result depending
+// only on the inputs (a size, support or surprisingness) to check
+// that the compared runs computed the same thing.
+
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencog/util/random.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/miner/MinerUtils.h>
+#include <opencog/miner/Valuations.h>
+#include <opencog/miner/Surprisingness.h>
+
+using namespace opencog;
+
+static Handle concept(const std::string& name)
+{
+	return createNode(CONCEPT_NODE, name);
+}
+
+static Handle inheritance(const Handle& l, const Handle& r)
+{
+	return createLink(INHERITANCE_LINK, l, r);
+}
+
+static HandleSeq gen_db(unsigned db_size)
+{
+	unsigned n_a = std::max(1U, db_size / 10);
+	HandleSeq db;
+	for (unsigned i = 0; i < db_size; i++)
+		db.push_back(inheritance(concept("A" + std::to_string(randGen().randint(n_a))),
+		                         concept("B" + std::to_string(randGen().randint(10)))));
+	return db;
+}
+
+// Patterns are created outside of any atomspace, thus each call
+// creates a new pattern atom, without the values memoized on
+// previous ones.
+static Handle gen_pattern(const std::string& shape)
+{
+	Handle X = createNode(VARIABLE_NODE, "$X"),
+		Y = createNode(VARIABLE_NODE, "$Y"),
+		Z = createNode(VARIABLE_NODE, "$Z"),
+		W = createNode(VARIABLE_NODE, "$W");
+	if (shape == "unary")
+		return MinerUtils::mk_pattern(X, {inheritance(X, concept("B0"))});
+	if (shape == "binary")
+		return MinerUtils::mk_pattern(MinerUtils::variable_set({X, Y}),
+		                              {inheritance(X, Y)});
+	if (shape == "star2")
+		return MinerUtils::mk_pattern(MinerUtils::variable_set({X, Y, Z}),
+		                              {inheritance(X, Y), inheritance(X, Z)});
+	return MinerUtils::mk_pattern(MinerUtils::variable_set({X, Y, Z, W}),
+	                              {inheritance(X, Y), inheritance(X, Z),
+	                               inheritance(X, W)});
+}
+
+// Run fun iterations times, return the total time in seconds, and
+// the result of its last call.
+static double time_iterations(unsigned iterations,
+                              const std::function<double()>& fun,
+                              double& result)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned i = 0; i < iterations; i++)
+		result = fun();
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+int main(int argc, char** argv)
+{
+	std::string db_sizes_str = 1 < argc ? argv[1] : "100,1000,10000";
+	unsigned iterations = 2 < argc ? std::stoul(argv[2]) : 10;
+	std::string filter = 3 < argc ? argv[3] : "";
+
+	std::vector<unsigned> db_sizes;
+	std::stringstream ss(db_sizes_str);
+	for (std::string size; std::getline(ss, size, ',');)
+		db_sizes.push_back(std::stoul(size));
+
+	std::cout << "benchmark,shape,db_size,iterations,seconds,"
+	          << "seconds_per_iteration,result" << std::endl;
+	auto run = [&](const std::string& name, const std::string& shape,
+	               unsigned db_size, const std::function<double()>& fun) {
+		if (name.find(filter) == std::string::npos)
+			return;
+		double result = 0.0;
+		double t = time_iterations(iterations, fun, result);
+		std::cout << name << "," << shape << "," << db_size << ","
+		          << iterations << "," << t << "," << t / iterations << ","
+		          << result << std::endl;
+	};
+
+	const std::vector<std::string> shapes{"unary", "binary", "star2", "star3"};
+	AtomSpacePtr scratch_as = createAtomSpace();
+	for (unsigned db_size : db_sizes) {
+		randGen().seed(0);
+		HandleSeq db = gen_db(db_size);
+		unsigned ms = std::max(2U, db_size / 100);
+
+		for (const std::string& shape : shapes) {
+			Handle pattern = gen_pattern(shape);
+			unsigned n_conjuncts = MinerUtils::n_conjuncts(pattern);
+			const HandleSeq& vars = MinerUtils::get_variables(pattern).varseq;
+
+			// Expensive for large dbs, as the number of groundings of
+			// a conjunction grows with the product of the number of
+			// groundings of its conjuncts
+			bool tractable = n_conjuncts == 1 or db_size <= 1000;
+
+			if (tractable) {
+				run("restricted_satisfying_set", shape, db_size, [&]() {
+						return MinerUtils::restricted_satisfying_set(pattern, db)->get_arity(); });
+				run("support", shape, db_size, [&]() {
+						return MinerUtils::support(pattern, db, UINT_MAX); });
+				run("valuations", shape, db_size, [&]() {
+						return Valuations(pattern, db).size(); });
+				Valuations valuations(pattern, db);
+				run("focus_shallow_abstract", shape, db_size, [&]() {
+						return MinerUtils::focus_shallow_abstract(valuations, ms,
+						                                          false, false).size(); });
+			}
+			run("compose_nocheck", shape, db_size, [&]() {
+					return MinerUtils::n_conjuncts(
+						MinerUtils::compose_nocheck(pattern, {vars.front(), vars.back()})); });
+			if (n_conjuncts == 1)
+				run("expand_conjunction", shape, db_size, [&]() {
+						return MinerUtils::expand_conjunction(pattern, pattern, db, ms).size(); });
+			run("partitions", shape, db_size, [&]() {
+					return MinerUtils::partitions(MinerUtils::get_clauses(pattern)).size(); });
+			// Only meaningful for conjunctions, and memoized on the
+			// pattern, thus calculated on a new pattern each time.
+			// Surprisingness memoizes the estimates of the
+			// subpatterns in the atomspace of the pattern, thus it is
+			// added to a scratch atomspace, cleared beforehand so that
+			// no estimate of a previous call is reused, like
+			// Miner::surprisingness_score
+			if (1 < n_conjuncts and tractable)
+				run("isurp", shape, db_size, [&]() {
+						scratch_as->clear();
+						return Surprisingness::isurp(
+							scratch_as->add_atom(gen_pattern(shape)), db); });
+		}
+	}
+
+	// Jensen-Shannon distance between truth values with counts
+	// ranging from 1 to 10^6, see jsd-benchmark for a comparison with
+	// its former implementation
+	randGen().seed(0);
+	TruthValueSeq tvs;
+	for (unsigned i = 0; i < 1000; i++) {
+		double count = std::pow(10.0, 6.0 * randGen().randdouble());
+		tvs.push_back(createSimpleTruthValue(
+			              randGen().randdouble(),
+			              Surprisingness::count_to_confidence(count)));
+	}
+	run("jsd", "tv", tvs.size(), [&]() {
+			double sum = 0.0;
+			for (size_t i = 0; i + 1 < tvs.size(); i++)
+				sum += Surprisingness::jsd(tvs[i], tvs[i + 1]);
+			return sum; });
+
+	return 0;
+}
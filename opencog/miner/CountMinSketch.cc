@@ -0,0 +1,74 @@
+/*
+ * CountMinSketch.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "CountMinSketch.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cmath>
+
+#include <opencog/util/oc_assert.h>
+
+namespace opencog
+{
+
+CountMinSketch::CountMinSketch(double epsilon, double delta)
+	: _total(0)
+{
+	OC_ASSERT(0 < epsilon and 0 < delta and delta < 1);
+	_width = std::ceil(std::exp(1.0) / epsilon);
+	_depth = std::max(1.0, std::ceil(std::log(1.0 / delta)));
+	_counters.resize((size_t)_width * _depth, 0);
+}
+
+void CountMinSketch::add(size_t key, unsigned count)
+{
+	for (unsigned row = 0; row < _depth; row++)
+		_counters[row * _width + column(key, row)] += count;
+	_total += count;
+}
+
+unsigned CountMinSketch::estimate(size_t key) const
+{
+	unsigned est = UINT_MAX;
+	for (unsigned row = 0; row < _depth; row++)
+		est = std::min(est, _counters[row * _width + column(key, row)]);
+	return est;
+}
+
+unsigned CountMinSketch::total() const
+{
+	return _total;
+}
+
+size_t CountMinSketch::column(size_t key, unsigned row) const
+{
+	// Derive one hash per row by mixing the key with the row index
+	// (splitmix64 finalizer)
+	uint64_t x = key + 0x9e3779b97f4a7c15ULL * (row + 1);
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+	x = x ^ (x >> 31);
+	return x % _width;
+}
+
+} // namespace opencog
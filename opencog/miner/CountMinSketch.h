@@ -0,0 +1,84 @@
+/*
+ * CountMinSketch.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENCOG_COUNT_MIN_SKETCH_H_
+#define OPENCOG_COUNT_MIN_SKETCH_H_
+
+#include <cstddef>
+#include <vector>
+
+namespace opencog
+{
+
+/**
+ * Count-Min sketch, see An Improved Data Stream Summary: The
+ * Count-Min Sketch and its Applications, from Cormode and
+ * Muthukrishnan.
+ *
+ * Approximately count keys (hashes) in memory independent of the
+ * number of distinct keys. The estimated count of a key is never
+ * below its actual count, thus can be used to discard keys that
+ * cannot reach a threshold without false negatives. With probability
+ * 1-delta the overestimation is at most epsilon times the total
+ * count.
+ */
+class CountMinSketch
+{
+public:
+	/**
+	 * CTor. The sketch has ceil(e/epsilon) columns and
+	 * ceil(ln(1/delta)) rows.
+	 */
+	CountMinSketch(double epsilon=0.001, double delta=0.01);
+
+	/**
+	 * Increase the count of key by count.
+	 */
+	void add(size_t key, unsigned count=1);
+
+	/**
+	 * Return the estimated count of key, an upper bound of its actual
+	 * count.
+	 */
+	unsigned estimate(size_t key) const;
+
+	/**
+	 * Return the sum of all counts added so far.
+	 */
+	unsigned total() const;
+
+private:
+	/**
+	 * Return the column of key in the given row.
+	 */
+	size_t column(size_t key, unsigned row) const;
+
+	unsigned _width;
+	unsigned _depth;
+	unsigned _total;
+
+	// Flattened depth x width matrix of counters
+	std::vector<unsigned> _counters;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_COUNT_MIN_SKETCH_H_ */
@@ -0,0 +1,282 @@
+/*
+ * DbSnapshot.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "DbSnapshot.h"
+#include "MinerLogger.h"
+
+#include <opencog/util/exceptions.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace opencog
+{
+
+static const char snapshot_magic[8] = "MINERDB";
+static const uint32_t snapshot_version = 1;
+
+DbSnapshot::DbSnapshot()
+	: _data(nullptr), _size(0), _atoms(nullptr), _outgoings(nullptr),
+	  _roots(nullptr), _names(nullptr), _n_atoms(0), _n_outgoings(0),
+	  _n_roots(0), _names_size(0) {}
+
+DbSnapshot::~DbSnapshot()
+{
+	close();
+}
+
+void DbSnapshot::save(const std::string& filename, const HandleSeq& db)
+{
+	// Number the distinct atoms, outgoing atoms first
+	std::map<Handle, uint64_t> indices;
+	std::map<Type, uint32_t> type_indices;
+	std::vector<AtomRecord> atoms;
+	std::vector<uint64_t> outgoings, roots;
+	std::string types, names;
+	std::function<uint64_t(const Handle&)> number = [&](const Handle& h) {
+		auto it = indices.find(h);
+		if (it != indices.end())
+			return it->second;
+		AtomRecord record;
+		auto tit = type_indices.find(h->get_type());
+		if (tit == type_indices.end()) {
+			tit = type_indices.emplace(h->get_type(), type_indices.size()).first;
+			types += nameserver().getTypeName(h->get_type());
+			types += '\0';
+		}
+		record.type = tit->second;
+		if (h->is_node()) {
+			record.arity = h->get_name().size();
+			record.offset = names.size();
+			names += h->get_name();
+		} else {
+			std::vector<uint64_t> outgoing;
+			for (const Handle& child : h->getOutgoingSet())
+				outgoing.push_back(number(child));
+			record.arity = outgoing.size();
+			record.offset = outgoings.size();
+			outgoings.insert(outgoings.end(), outgoing.begin(), outgoing.end());
+		}
+		atoms.push_back(record);
+		return indices[h] = atoms.size() - 1;
+	};
+	for (const Handle& dt : db)
+		roots.push_back(number(dt));
+
+	Header header;
+	std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+	header.version = snapshot_version;
+	header.n_types = type_indices.size();
+	header.n_atoms = atoms.size();
+	header.n_outgoings = outgoings.size();
+	header.n_roots = roots.size();
+	header.types_size = types.size();
+	header.names_size = names.size();
+
+	std::string tmp_filename = filename + ".tmp";
+	{
+		std::ofstream out(tmp_filename, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(atoms.data()),
+		          atoms.size() * sizeof(AtomRecord));
+		out.write(reinterpret_cast<const char*>(outgoings.data()),
+		          outgoings.size() * sizeof(uint64_t));
+		out.write(reinterpret_cast<const char*>(roots.data()),
+		          roots.size() * sizeof(uint64_t));
+		out.write(types.data(), types.size());
+		out.write(names.data(), names.size());
+		if (not out)
+			throw RuntimeException(TRACE_INFO, "Cannot write db snapshot %s",
+			                       tmp_filename.c_str());
+	}
+	if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+		throw RuntimeException(TRACE_INFO, "Cannot write db snapshot %s",
+		                       filename.c_str());
+}
+
+void DbSnapshot::open(const std::string& filename)
+{
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	struct stat st;
+	if (fd < 0 or fstat(fd, &st) != 0) {
+		if (0 <= fd)
+			::close(fd);
+		throw RuntimeException(TRACE_INFO, "Cannot open db snapshot %s",
+		                       filename.c_str());
+	}
+	_size = st.st_size;
+	void* data = _size < sizeof(Header) ? MAP_FAILED
+		: mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data == MAP_FAILED)
+		throw RuntimeException(TRACE_INFO, "%s is not a db snapshot",
+		                       filename.c_str());
+	_data = data;
+
+	// Check the header, and that the sections exactly fill the file,
+	// taking each section from the remaining size so that ill-formed
+	// counts cannot overflow
+	const Header& header = *static_cast<const Header*>(_data);
+	const char* begin = static_cast<const char*>(_data);
+	size_t remaining = _size - sizeof(Header);
+	auto take = [&](uint64_t count, size_t item_size) {
+		if (remaining / item_size < count)
+			return false;
+		remaining -= count * item_size;
+		return true;
+	};
+	bool fits = take(header.n_atoms, sizeof(AtomRecord))
+		and take(header.n_outgoings, sizeof(uint64_t))
+		and take(header.n_roots, sizeof(uint64_t))
+		and take(header.types_size, 1)
+		and take(header.names_size, 1)
+		and remaining == 0;
+	if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0
+	    or header.version != snapshot_version or not fits) {
+		close();
+		throw RuntimeException(TRACE_INFO, "%s is not a db snapshot",
+		                       filename.c_str());
+	}
+	_n_atoms = header.n_atoms;
+	_n_outgoings = header.n_outgoings;
+	_n_roots = header.n_roots;
+	_names_size = header.names_size;
+	_atoms = reinterpret_cast<const AtomRecord*>(begin + sizeof(Header));
+	_outgoings = reinterpret_cast<const uint64_t*>(_atoms + _n_atoms);
+	_roots = _outgoings + _n_outgoings;
+	const char* types = reinterpret_cast<const char*>(_roots + _n_roots);
+	_names = types + header.types_size;
+	_materialized.resize(_n_atoms);
+
+	// Map the type names to the types of the nameserver, each name
+	// being terminated within the section
+	for (const char* tn = types; tn < _names;) {
+		size_t length = strnlen(tn, _names - tn);
+		std::string name(tn, length);
+		Type type = length < (size_t)(_names - tn) ?
+			nameserver().getType(name) : NOTYPE;
+		if (type == NOTYPE) {
+			close();
+			throw RuntimeException(TRACE_INFO, "Unknown type %s in db snapshot %s",
+			                       name.c_str(), filename.c_str());
+		}
+		_types.push_back(type);
+		tn += length + 1;
+	}
+
+	LAZY_MINER_LOG_DEBUG << "Open db snapshot " << filename << " with "
+	                     << _n_roots << " data trees and "
+	                     << _n_atoms << " distinct atoms";
+}
+
+void DbSnapshot::close()
+{
+	if (_data)
+		munmap(_data, _size);
+	_data = nullptr;
+	_size = 0;
+	_atoms = nullptr;
+	_outgoings = _roots = nullptr;
+	_names = nullptr;
+	_n_atoms = _n_outgoings = _n_roots = _names_size = 0;
+	_types.clear();
+	_materialized.clear();
+}
+
+size_t DbSnapshot::size() const
+{
+	return _n_roots;
+}
+
+Handle DbSnapshot::data_tree(size_t i) const
+{
+	if (_n_roots <= i)
+		throw RuntimeException(TRACE_INFO, "No data tree %zu in db snapshot", i);
+	return materialize(_roots[i]);
+}
+
+HandleSeq DbSnapshot::get_db() const
+{
+	return view().range(0, _n_roots);
+}
+
+DbView DbSnapshot::view() const
+{
+	return DbView(_n_roots, [this](size_t begin, size_t end) {
+			HandleSeq data_trees;
+			data_trees.reserve(end - begin);
+			for (size_t i = begin; i < end; i++)
+				data_trees.push_back(materialize(_roots[i]));
+			return data_trees; });
+}
+
+Handle DbSnapshot::materialize(uint64_t index) const
+{
+	if (_n_atoms <= index)
+		throw RuntimeException(TRACE_INFO, "Ill-formed db snapshot");
+	Handle memoized(_materialized[index].lock());
+	if (memoized)
+		return memoized;
+
+	const AtomRecord& record = _atoms[index];
+	if (_types.size() <= record.type)
+		throw RuntimeException(TRACE_INFO, "Ill-formed db snapshot");
+	Type type = _types[record.type];
+	if (nameserver().isNode(type)) {
+		if (_names_size < record.offset
+		    or _names_size - record.offset < record.arity)
+			throw RuntimeException(TRACE_INFO, "Ill-formed db snapshot");
+		memoized = createNode(type, std::string(_names + record.offset,
+		                                        record.arity));
+	} else {
+		if (_n_outgoings < record.offset
+		    or _n_outgoings - record.offset < record.arity)
+			throw RuntimeException(TRACE_INFO, "Ill-formed db snapshot");
+		HandleSeq outgoing;
+		outgoing.reserve(record.arity);
+		for (uint32_t k = 0; k < record.arity; k++) {
+			// Outgoing atoms precede the links they are in
+			uint64_t child = _outgoings[record.offset + k];
+			if (index <= child)
+				throw RuntimeException(TRACE_INFO, "Ill-formed db snapshot");
+			outgoing.push_back(materialize(child));
+		}
+		memoized = createLink(std::move(outgoing), type);
+	}
+	_materialized[index] = memoized;
+	return memoized;
+}
+
+} // namespace opencog
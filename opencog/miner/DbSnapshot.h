@@ -0,0 +1,179 @@
+/*
+ * DbSnapshot.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OPENCOG_MINER_DB_SNAPSHOT_H_
+#define OPENCOG_MINER_DB_SNAPSHOT_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencog/atoms/base/Handle.h>
+
+#include "DbView.h"
+
+namespace opencog
+{
+
+/**
+ * Read-only snapshot of a db, stored in a compact binary file, so
+ * that large mining corpora can be loaded without parsing Scheme nor
+ * adding their data trees to an atomspace. The file is memory-mapped
+ * and atoms are only created, outside of any atomspace, when data
+ * trees are materialized. Materialized atoms are memoized as long as
+ * they are in use, so that subtrees shared by data trees in use are
+ * materialized once, while those no longer in use are released.
+ * data_tree materializes a single data tree on demand, view a range
+ * of them, so that the snapshot can be mined streaming its data
+ * trees, see Miner::mine_forest(const DbView&), while get_db
+ * materializes them all in memory at once. A snapshot is not thread
+ * safe.
+ *
+ * The file is a binary file, in the byte order of the host, made of
+ * a header
+ *
+ * <MAGIC> <VERSION> <N TYPES> <N ATOMS> <N OUTGOINGS> <N ROOTS> <TYPES SIZE> <NAMES SIZE>
+ *
+ * where MAGIC is the string "MINERDB" followed by a null character,
+ * VERSION and N TYPES are on 4 bytes, and the remaining counts and
+ * sizes on 8 bytes, followed by the sections
+ *
+ * <ATOMS> <OUTGOINGS> <ROOTS> <TYPES> <NAMES>
+ *
+ * ATOMS holds, for each distinct atom of the db, its type, as an
+ * index in TYPES, and its arity on 4 bytes each, and its offset on 8
+ * bytes, that is the offset of its name in NAMES for a node, its
+ * arity being the length of its name, and the offset of its outgoing
+ * set in OUTGOINGS for a link. Atoms are ordered so that outgoing
+ * atoms precede the links they are in, shared subtrees being stored
+ * once. OUTGOINGS and ROOTS hold indices of atoms in ATOMS on 8 bytes
+ * each, ROOTS being the data trees of the db. TYPES holds the names
+ * of the types used, each followed by a null character, so that the
+ * file does not depend on the numbering of types, and NAMES the
+ * names of the nodes, without separators.
+ */
+class DbSnapshot
+{
+public:
+	/**
+	 * CTor, closed snapshot.
+	 */
+	DbSnapshot();
+	~DbSnapshot();
+
+	DbSnapshot(const DbSnapshot&) = delete;
+	DbSnapshot& operator=(const DbSnapshot&) = delete;
+
+	/**
+	 * Write the data trees of db to the given file, first to a
+	 * temporary file then renamed, like MinerCheckpoint::save. Throw
+	 * a RuntimeException on failure.
+	 */
+	static void save(const std::string& filename, const HandleSeq& db);
+
+	/**
+	 * Memory-map the given file, after closing the snapshot if already
+	 * open. Throw a RuntimeException if it cannot be mapped or is
+	 * ill-formed.
+	 */
+	void open(const std::string& filename);
+
+	/**
+	 * Unmap the file, if any.
+	 */
+	void close();
+
+	/**
+	 * Return the number of data trees of the db, 0 if closed.
+	 */
+	size_t size() const;
+
+	/**
+	 * Materialize the i-th data tree, outside of any atomspace.
+	 */
+	Handle data_tree(size_t i) const;
+
+	/**
+	 * Materialize all data trees, outside of any atomspace, sharing
+	 * their common subtrees. They are all held in memory at once.
+	 */
+	HandleSeq get_db() const;
+
+	/**
+	 * Return an index-based view of the data trees, materializing them
+	 * range by range when accessed. The snapshot must outlive the view
+	 * and remain open.
+	 */
+	DbView view() const;
+
+private:
+	struct Header
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t n_types;
+		uint64_t n_atoms;
+		uint64_t n_outgoings;
+		uint64_t n_roots;
+		uint64_t types_size;
+		uint64_t names_size;
+	};
+
+	struct AtomRecord
+	{
+		uint32_t type;
+		uint32_t arity;
+		uint64_t offset;
+	};
+
+	/**
+	 * Materialize the atom at the given index in ATOMS, or return it
+	 * if memoized and still in use.
+	 */
+	Handle materialize(uint64_t index) const;
+
+	// Mapped file and its size, nullptr if closed
+	void* _data;
+	size_t _size;
+
+	// Sections of the mapped file
+	const AtomRecord* _atoms;
+	const uint64_t* _outgoings;
+	const uint64_t* _roots;
+	const char* _names;
+	uint64_t _n_atoms;
+	uint64_t _n_outgoings;
+	uint64_t _n_roots;
+	uint64_t _names_size;
+
+	// Types of TYPES, in the numbering of the nameserver
+	std::vector<Type> _types;
+
+	// Materialized atoms, indexed like ATOMS, only referenced weakly
+	// so that they are released once no longer in use
+	mutable std::vector<std::weak_ptr<Atom>> _materialized;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_DB_SNAPSHOT_H_ */
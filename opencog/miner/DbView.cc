@@ -0,0 +1,48 @@
+/*
+ * DbView.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "DbView.h"
+
+#include <opencog/util/oc_assert.h>
+
+namespace opencog
+{
+
+DbView::DbView(const HandleSeq& db)
+	: _size(db.size()),
+	  _range([&db](size_t begin, size_t end) {
+		  return HandleSeq(db.begin() + begin, db.begin() + end); }) {}
+
+DbView::DbView(size_t size, const Range& range)
+	: _size(size), _range(range) {}
+
+size_t DbView::size() const
+{
+	return _size;
+}
+
+HandleSeq DbView::range(size_t begin, size_t end) const
+{
+	OC_ASSERT(begin <= end and end <= _size);
+	return _range(begin, end);
+}
+
+} // namespace opencog
@@ -0,0 +1,71 @@
+/*
+ * DbView.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENCOG_MINER_DB_VIEW_H_
+#define OPENCOG_MINER_DB_VIEW_H_
+
+#include <cstddef>
+#include <functional>
+
+#include <opencog/atoms/base/Handle.h>
+
+namespace opencog
+{
+
+/**
+ * Index-based view of a db, whose data trees are only materialized,
+ * range by range, when accessed, so that a db, like that of a
+ * DbSnapshot, can be streamed without holding all its data trees in
+ * memory at once, see DbSnapshot::view.
+ */
+class DbView
+{
+public:
+	typedef std::function<HandleSeq(size_t begin, size_t end)> Range;
+
+	/**
+	 * View of the data trees of db, which must outlive the view.
+	 */
+	explicit DbView(const HandleSeq& db);
+
+	/**
+	 * View of size data trees, materialized by range.
+	 */
+	DbView(size_t size, const Range& range);
+
+	/**
+	 * Return the number of data trees.
+	 */
+	size_t size() const;
+
+	/**
+	 * Return the data trees in [begin, end).
+	 */
+	HandleSeq range(size_t begin, size_t end) const;
+
+private:
+	size_t _size;
+	Range _range;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_DB_VIEW_H_ */
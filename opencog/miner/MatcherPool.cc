@@ -0,0 +1,97 @@
+/*
+ * MatcherPool.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MatcherPool.h"
+
+namespace opencog
+{
+
+MatcherPool::MatcherPool()
+	: _task(nullptr), _jobs(0), _pending(0), _generation(0), _stop(false) {}
+
+MatcherPool::~MatcherPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_start.notify_all();
+	for (std::thread& thread : _threads)
+		thread.join();
+}
+
+void MatcherPool::run(unsigned jobs, const Task& task)
+{
+	std::lock_guard<std::mutex> run_lock(_run_mutex);
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (_threads.size() < jobs) {
+		_atomspaces.push_back(createAtomSpace());
+		_threads.emplace_back(&MatcherPool::loop, this, _threads.size());
+	}
+
+	_task = &task;
+	_jobs = jobs;
+	_pending = jobs;
+	_error = nullptr;
+	_generation++;
+	_start.notify_all();
+	_done.wait(lock, [&]() { return _pending == 0; });
+	_task = nullptr;
+
+	if (_error)
+		std::rethrow_exception(_error);
+}
+
+void MatcherPool::loop(unsigned j)
+{
+	unsigned generation = 0;
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (true) {
+		_start.wait(lock, [&]() {
+			return _stop or (generation != _generation and j < _jobs); });
+		if (_stop)
+			return;
+		generation = _generation;
+
+		// The atomspaces are only added between runs
+		lock.unlock();
+		std::exception_ptr error;
+		try {
+			(*_task)(_atomspaces[j]);
+		} catch (...) {
+			error = std::current_exception();
+		}
+		lock.lock();
+
+		if (error and not _error)
+			_error = error;
+		if (--_pending == 0)
+			_done.notify_all();
+	}
+}
+
+MatcherPool& matcher_pool()
+{
+	static MatcherPool instance;
+	return instance;
+}
+
+} // namespace opencog
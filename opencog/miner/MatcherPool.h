@@ -0,0 +1,106 @@
+/*
+ * MatcherPool.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OPENCOG_MINER_MATCHER_POOL_H_
+#define OPENCOG_MINER_MATCHER_POOL_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencog/atomspace/AtomSpace.h>
+
+namespace opencog
+{
+
+/**
+ * Persistent pool of threads running the pattern matcher over shards
+ * of a db, see MinerUtils::sharded_satisfying_set. Each thread owns
+ * a temporary atomspace, kept across tasks, to copy its shards into,
+ * so that neither threads nor atomspaces are created per call.
+ *
+ * Threads are started on first need, up to the largest number of
+ * jobs ever requested, and stopped when the pool is destroyed.
+ */
+class MatcherPool
+{
+public:
+	typedef std::function<void(const AtomSpacePtr& tmp_as)> Task;
+
+	/**
+	 * CTor, no thread is started yet.
+	 */
+	MatcherPool();
+
+	/**
+	 * DTor, stop and join the threads.
+	 */
+	~MatcherPool();
+
+	/**
+	 * Call task on jobs threads of the pool, each passing the
+	 * temporary atomspace of its thread, and wait till all calls
+	 * return. Calls from different threads are serialized. If a call
+	 * throws, the first exception is rethrown once all calls have
+	 * returned.
+	 */
+	void run(unsigned jobs, const Task& task);
+
+private:
+	/**
+	 * Loop of thread j, calling the task of each run it takes part
+	 * in.
+	 */
+	void loop(unsigned j);
+
+	std::vector<std::thread> _threads;
+	std::vector<AtomSpacePtr> _atomspaces;
+
+	// Current run: its task, number of jobs and number of calls not
+	// returned yet, and how many runs have been started, so that each
+	// thread takes part in a run once
+	const Task* _task;
+	unsigned _jobs;
+	unsigned _pending;
+	unsigned _generation;
+	std::exception_ptr _error;
+	bool _stop;
+
+	// Serialize runs
+	std::mutex _run_mutex;
+
+	// Protect the state above, signal the threads of a new run, and
+	// the caller of the end of the run
+	std::mutex _mutex;
+	std::condition_variable _start;
+	std::condition_variable _done;
+};
+
+// singleton instance (following Meyer's design pattern)
+MatcherPool& matcher_pool();
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_MATCHER_POOL_H_ */
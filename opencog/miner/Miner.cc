@@ -22,18 +22,25 @@
  */
 
 #include "Miner.h"
+#include "MinerCache.h"
+#include "MinerLogger.h"
+#include "Surprisingness.h"
 
 #include <opencog/atoms/execution/Instantiator.h>
 #include <opencog/atoms/core/LambdaLink.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
 
 #include <opencog/util/Logger.h>
 #include <opencog/util/algorithm.h>
+#include <opencog/util/oc_assert.h>
 
 #include <boost/range/algorithm/min_element.hpp>
 #include <boost/range/numeric.hpp>
 #include <boost/range/algorithm/transform.hpp>
 
+#include <cmath>
 #include <functional>
+#include <memory>
 
 namespace opencog
 {
@@ -44,7 +51,12 @@ namespace opencog
 MinerParameters::MinerParameters(unsigned ms, unsigned iconjuncts,
                                  const Handle& ipat, int maxd)
 	: minsup(ms), initconjuncts(iconjuncts), initpat(ipat),
-	  maxdepth(maxd)
+	  maxdepth(maxd), valuations_chunk_size(0), jobs(1),
+	  approx_shallow_abstract(false), output_mode(ALL), top_k(0),
+	  time_budget(0), memory_budget(0), checkpoint_interval(60),
+	  maximum_conjuncts(1), enforce_specialization(true),
+	  maximum_variables(UINT_MAX), maximum_cnjexp_variables(UINT_MAX),
+	  maximum_spcial_conjuncts(UINT_MAX)
 {
 	// Provide initial pattern if none
 	if (not initpat) {
@@ -71,8 +83,17 @@ MinerParameters::MinerParameters(unsigned ms, unsigned iconjuncts,
 }
 
 Miner::Miner(const MinerParameters& prm)
-	: param(prm)
+	: param(prm), effective_minsup(prm.minsup), weights(nullptr),
+	  db_view(nullptr),
+	  budget_exhausted(false), budget_checks(0), sample_complete(true),
+	  checkpointing(false),
+	  explicit_parent(false), parent_index(PatternForest::npos),
+	  passed_count(0), deduplicating(false)
 {
+	// Checked here rather than when the valuations are built, in the
+	// middle of the search
+	OC_ASSERT(param.jobs < 2 or param.valuations_chunk_size == 0,
+	          "Valuations cannot be streamed by chunks over several jobs");
 	tmp_as = createAtomSpace(); // Hmm Not used anywhere ...
 }
 
@@ -85,7 +106,424 @@ HandleTree Miner::operator()(const AtomSpace& db_as)
 
 HandleTree Miner::operator()(const HandleSeq& db)
 {
-	return specialize(param.initpat, db, param.maxdepth);
+	return mine_forest(db).to_handle_tree();
+}
+
+void Miner::operator()(const AtomSpace& db_as, const PatternCallback& cb)
+{
+	HandleSeq db;
+	db_as.get_handles_by_type(db, opencog::ATOM, true);
+	operator()(db, cb);
+}
+
+void Miner::operator()(const HandleSeq& db, const PatternCallback& cb)
+{
+	mine(db, get_valuations(param.initpat, db), cb);
+}
+
+PatternForest Miner::mine_forest(const AtomSpace& db_as)
+{
+	HandleSeq db;
+	db_as.get_handles_by_type(db, opencog::ATOM, true);
+	return mine_forest(db);
+}
+
+PatternForest Miner::mine_forest(const HandleSeq& db)
+{
+	PatternForest patterns;
+	operator()(db, forest_inserter(patterns));
+	return param.top_k == 0 ? patterns
+		: patterns.filter_support(effective_minsup);
+}
+
+PatternForest Miner::mine_forest(const HandleUCounter& wdb)
+{
+	weights = &wdb;
+	PatternForest patterns = mine_forest(MinerUtils::db_trees(wdb));
+	weights = nullptr;
+	return patterns;
+}
+
+PatternForest Miner::mine_forest(const DbView& db)
+{
+	OC_ASSERT(param.maximum_conjuncts <= 1 and param.checkpoint_file.empty()
+	          and param.jobs < 2,
+	          "A db view cannot be mined with conjunction expansion, "
+	          "checkpoints nor several jobs");
+	db_view = &db;
+	PatternForest patterns = mine_forest(HandleSeq());
+	db_view = nullptr;
+	return patterns;
+}
+
+PatternLattice Miner::mine_lattice(const AtomSpace& db_as)
+{
+	HandleSeq db;
+	db_as.get_handles_by_type(db, opencog::ATOM, true);
+	return mine_lattice(db);
+}
+
+PatternLattice Miner::mine_lattice(const HandleSeq& db)
+{
+	PatternLattice lattice;
+	Valuations valuations = get_valuations(param.initpat, db);
+	unsigned top = lattice.add(param.initpat, valuations.size());
+	mine(db, valuations, lattice_inserter(lattice, top));
+	if (param.top_k == 0)
+		return lattice;
+
+	// Drop the patterns passed before the effective minimum support
+	// rose above their supports, keeping the initial pattern, which
+	// is only below it if no pattern has been passed.
+	return lattice.filter_support(std::min(effective_minsup,
+	                                       lattice.support(top)));
+}
+
+PatternForest Miner::mine_incremental(const PatternForest& patterns,
+                                     const HandleSeq& db,
+                                     const HandleSeq& delta,
+                                     const HandleSeq& removed)
+{
+	// Subtrees of the previous db, that is db without delta and with
+	// removed, and of db, so that a grounding of a unary pattern
+	// shared by several data trees is only counted when it first
+	// appears, and when it disappears from all of them.
+	HandleContentSizeMap previous_subtrees, subtrees, delta_counts;
+	for (const Handle& dt : delta)
+		delta_counts[dt]++;
+	for (const Handle& dt : db) {
+		auto it = delta_counts.find(dt);
+		if (it != delta_counts.end() and 0 < it->second)
+			it->second--;
+		else
+			MinerUtils::record_subtrees(dt, 0, previous_subtrees);
+		if (not removed.empty())
+			MinerUtils::record_subtrees(dt, 0, subtrees);
+	}
+	for (const Handle& dt : removed)
+		MinerUtils::record_subtrees(dt, 0, previous_subtrees);
+
+	// Number of distinct groundings of pattern over trees that are
+	// not subtrees in excluded
+	auto n_groundings_outside = [&](const Handle& pattern,
+	                                const HandleSeq& trees,
+	                                const HandleContentSizeMap& excluded) {
+		size_t count = 0;
+		MinerUtils::foreach_grounding(pattern, trees,
+		                              param.valuations_chunk_size,
+		                              [&](const Handle& grounding) {
+			                              if (excluded.find(grounding) == excluded.end())
+				                              count++; });
+		return count;
+	};
+
+	// Previous supports, by pattern
+	std::unordered_map<Handle, unsigned, HandleContentHash,
+	                   HandleContentEqual> supports;
+	for (unsigned i = 0; i < patterns.size(); i++)
+		supports.emplace(patterns.pattern(i), patterns.support(i));
+
+	return mine_incremental(patterns, db, delta, removed,
+	                        [&](const Handle& pattern) {
+		size_t gained = supports.at(pattern)
+			+ n_groundings_outside(pattern, delta, previous_subtrees),
+			lost = n_groundings_outside(pattern, removed, subtrees);
+		return (unsigned)(lost < gained ? gained - lost : 0);
+	});
+}
+
+PatternForest Miner::mine_incremental(const PatternForest& patterns,
+                                     const HandleSeq& db,
+                                     const HandleSeq& delta,
+                                     const HandleSeq& removed,
+                                     const UnarySupport& unary_support)
+{
+	OC_ASSERT(param.output_mode == MinerParameters::ALL and
+	          param.top_k == 0 and param.maximum_conjuncts <= 1,
+	          "Incremental mining only supports the ALL output mode, "
+	          "without top-k nor conjunction expansion");
+	init_search();
+	deduplicating = true;
+
+	// Update the supports of the previous patterns, parents preceding
+	// their children. The valuations of a totally abstract pattern
+	// are the data trees themselves, thus its support is simply
+	// calculated again.
+	PatternForest updated;
+	for (unsigned i = 0; i < patterns.size(); i++) {
+		const Handle& pattern = patterns.pattern(i);
+		unsigned support =
+			MinerUtils::n_conjuncts(pattern) == 1
+			and not MinerUtils::totally_abstract(pattern) ?
+			unary_support(pattern) : get_valuations(pattern, db).size();
+		updated.add(pattern, support, patterns.parent(i));
+		explored.insert(pattern->get_hash());
+	}
+
+	// Extend the search from the previous patterns
+	unsigned n_previous = updated.size();
+	extend_incremental(updated, PatternForest::npos, param.initpat, db, delta,
+	                   1, param.maxdepth);
+	for (unsigned i = 0; i < n_previous; i++) {
+		int maxdepth = param.maxdepth < 0 ? param.maxdepth
+			: param.maxdepth - (int)updated.depth(i) - 1;
+		Handle pattern = updated.pattern(i);
+		extend_incremental(updated, i, pattern, db, delta, 1, maxdepth);
+	}
+	deduplicating = false;
+
+	// Specializations of patterns below the minimum support are below
+	// it as well.
+	return removed.empty() ? updated : updated.filter_support(effective_minsup);
+}
+
+PatternForest Miner::mine_warm_start(const PatternForest& patterns,
+                                     const HandleSeq& db)
+{
+	OC_ASSERT(param.output_mode == MinerParameters::ALL and
+	          param.top_k == 0 and param.maximum_conjuncts <= 1,
+	          "Warm start mining only supports the ALL output mode, "
+	          "without top-k nor conjunction expansion");
+	init_search();
+	deduplicating = true;
+
+	PatternForest warmed(patterns);
+	for (unsigned i = 0; i < patterns.size(); i++)
+		explored.insert(patterns.pattern(i)->get_hash());
+
+	// Extend the search from the frontier pruned by the previous
+	// search, that is the shallow specializations of the previous
+	// patterns reaching the new minimum support over db.
+	LAZY_MINER_LOG_DEBUG << "Warm start from " << patterns.size()
+	                     << " patterns with minimum support "
+	                     << effective_minsup;
+	unsigned n_previous = warmed.size();
+	extend_incremental(warmed, PatternForest::npos, param.initpat, db, db,
+	                   effective_minsup, param.maxdepth);
+	for (unsigned i = 0; i < n_previous; i++) {
+		int maxdepth = param.maxdepth < 0 ? param.maxdepth
+			: param.maxdepth - (int)warmed.depth(i) - 1;
+		Handle pattern = warmed.pattern(i);
+		extend_incremental(warmed, i, pattern, db, db, effective_minsup,
+		                   maxdepth);
+	}
+	deduplicating = false;
+	return warmed;
+}
+
+PatternForest Miner::mine_sample(const HandleSeq& db, unsigned sample_size,
+                                 double lowering)
+{
+	OC_ASSERT(param.output_mode == MinerParameters::ALL and
+	          param.top_k == 0 and param.maximum_conjuncts <= 1,
+	          "Sample mining only supports the ALL output mode, "
+	          "without top-k nor conjunction expansion");
+
+	// Phase 1: mine the sample with a scaled and lowered minimum
+	// support
+	HandleSeq sample = sample_size < db.size() ?
+		Surprisingness::subsmp(db, sample_size) : db;
+	MinerParameters sample_param(param);
+	sample_param.minsup = std::max(1.0, std::floor(lowering * param.minsup
+	                                               * sample.size() / db.size()));
+	sample_param.checkpoint_file.clear();
+	PatternForest candidates = Miner(sample_param).mine_forest(sample);
+	LAZY_MINER_LOG_DEBUG << "Sample of " << sample.size() << " data trees "
+	                     << "with minimum support " << sample_param.minsup
+	                     << " has " << candidates.size() << " candidates";
+
+	// Phase 2: compute the negative border from the sample, that is
+	// the shallow specializations of param.initpat and the
+	// candidates, occurring in the sample, that are not candidates
+	// themselves, with the index of the candidate they specialize.
+	init_search();
+	HandleSeq cpats;
+	for (unsigned i = 0; i < candidates.size(); i++) {
+		cpats.push_back(candidates.pattern(i));
+		explored.insert(cpats.back()->get_hash());
+	}
+	HandleSeq border;
+	std::vector<unsigned> border_parents;
+	auto add_border = [&](const Handle& pattern, unsigned parent, int maxdepth) {
+		if (maxdepth == 0)
+			return;
+		foreach_shallow_specialization(pattern, sample, 1,
+		                               [&](const Handle& npat) {
+			                               border.push_back(npat);
+			                               border_parents.push_back(parent); });
+	};
+	add_border(param.initpat, PatternForest::npos, param.maxdepth);
+	for (unsigned i = 0; i < candidates.size(); i++)
+		add_border(cpats[i], i, param.maxdepth < 0 ? param.maxdepth
+		           : param.maxdepth - (int)candidates.depth(i) - 1);
+
+	// Phase 3: verify the candidates and check the border over db, in
+	// one batched pass. As specializations do not have a greater
+	// support, parents precede their children, and the candidates not
+	// reaching the minimum support are pruned with their
+	// specializations.
+	unsigned n_candidates = cpats.size();
+	cpats.insert(cpats.end(), border.begin(), border.end());
+	std::vector<unsigned> sups = MinerUtils::supports(cpats, db);
+	PatternForest verified;
+	std::vector<unsigned> indices(n_candidates, PatternForest::npos);
+	for (unsigned i = 0; i < n_candidates; i++) {
+		unsigned parent = candidates.parent(i);
+		if (sups[i] < effective_minsup
+		    or (parent != PatternForest::npos
+		        and indices[parent] == PatternForest::npos))
+			continue;
+		indices[i] = verified.add(cpats[i], sups[i], parent == PatternForest::npos ?
+		                          PatternForest::npos : indices[parent]);
+	}
+
+	// Only extend the search from the border patterns reaching the
+	// minimum support, under the candidate they specialize, if
+	// verified, and specialized as usual from there.
+	unsigned n_verified = verified.size(), n_frequent = 0;
+	deduplicating = true;
+	for (unsigned b = 0; b < border.size(); b++) {
+		unsigned parent = border_parents[b];
+		unsigned sup = sups[n_candidates + b];
+		if (sup < effective_minsup
+		    or (parent != PatternForest::npos
+		        and indices[parent] == PatternForest::npos))
+			continue;
+		n_frequent++;
+		parent = parent == PatternForest::npos ? parent : indices[parent];
+		int maxdepth = param.maxdepth < 0 ? param.maxdepth
+			: parent == PatternForest::npos ? param.maxdepth
+			: param.maxdepth - (int)verified.depth(parent) - 1;
+		unsigned index = verified.add(border[b], sup, parent);
+		PatternForest npats;
+		specialize(border[b], db, get_valuations(border[b], db), maxdepth - 1,
+		           1, forest_inserter(npats));
+		verified.merge(std::move(npats), index);
+	}
+	deduplicating = false;
+	sample_complete = n_frequent == 0;
+	LAZY_MINER_LOG_INFO << n_verified << " of " << n_candidates
+	                    << " candidates verified, " << n_frequent
+	                    << " of " << border.size() << " patterns of the "
+	                    << "negative border frequent, "
+	                    << (sample_complete ? "" : "not ")
+	                    << "complete from the sample";
+	return verified;
+}
+
+void Miner::extend_incremental(PatternForest& patterns,
+                               unsigned parent,
+                               const Handle& pattern,
+                               const HandleSeq& db,
+                               const HandleSeq& delta,
+                               unsigned ms,
+                               int maxdepth)
+{
+	if (maxdepth == 0 or pattern->get_type() != LAMBDA_LINK)
+		return;
+
+	// Only the specializations occurring at least ms times in delta
+	// may have a different support than before.
+	foreach_shallow_specialization(pattern, delta, ms, [&](const Handle& npat) {
+			if (not enough_support(npat, db))
+				return;
+			Valuations nvals = get_valuations(npat, db);
+			if (nvals.size() < effective_minsup)
+				return;
+
+			// npat has newly reached the minimum support, add it and
+			// its specializations.
+			unsigned index = patterns.add(npat, nvals.size(), parent);
+			PatternForest npats;
+			specialize(npat, db, nvals, maxdepth - 1, 1, forest_inserter(npats));
+			patterns.merge(std::move(npats), index);
+		});
+}
+
+void Miner::foreach_shallow_specialization(const Handle& pattern,
+                                           const HandleSeq& db,
+                                           unsigned ms,
+                                           const std::function<void(const Handle&)>& fun)
+{
+	if (pattern->get_type() != LAMBDA_LINK)
+		return;
+
+	Valuations vals = get_valuations(pattern, db);
+	for (; not vals.no_focus(); vals.inc_focus_variable()) {
+		HandleSet shapats = MinerUtils::focus_shallow_abstract(vals, ms, false, false,
+		                                                       param.approx_shallow_abstract);
+		Handle var = vals.focus_variable();
+		for (const Handle& shapat : shapats) {
+			Handle npat = nameserver().isA(shapat->get_type(), VARIABLE_NODE) ?
+				MinerUtils::compose_nocheck(pattern, {var, shapat}) :
+				MinerUtils::compose(pattern, {{var, shapat}});
+			if (MinerUtils::n_conjuncts(npat) < param.initconjuncts or
+			    param.maximum_variables < MinerUtils::get_variables(npat).size())
+				continue;
+			if (not explored.insert(npat->get_hash()).second)
+				continue;
+			fun(npat);
+		}
+	}
+}
+
+unsigned Miner::get_effective_minsup() const
+{
+	return effective_minsup;
+}
+
+bool Miner::is_budget_exhausted() const
+{
+	return budget_exhausted;
+}
+
+bool Miner::is_sample_complete() const
+{
+	return sample_complete;
+}
+
+unsigned Miner::get_parent_index() const
+{
+	return parent_index;
+}
+
+PatternScore Miner::support_score()
+{
+	return [](const Handle&, unsigned support) { return support; };
+}
+
+PatternScore Miner::conjuncts_score()
+{
+	return [](const Handle& pattern, unsigned) {
+		return MinerUtils::n_conjuncts(pattern); };
+}
+
+PatternScore Miner::surprisingness_score(const HandleSeq& db)
+{
+	// The patterns built by the miner are not in any atomspace, while
+	// Surprisingness::ji_tv_est adds their subpatterns to theirs to
+	// memoize their empirical truth values, thus add them to a
+	// scratch atomspace, shared by the calls of the score so that the
+	// estimates of common subpatterns are reused. Since each pattern
+	// is only scored once, the scratch atomspace is cleared, memoized
+	// estimates included, whenever it grows past scratch_size, to
+	// bound its memory over a long search.
+	static const size_t scratch_size = 100000;
+	AtomSpacePtr scratch_as = createAtomSpace();
+	return [db, scratch_as](const Handle& pattern, unsigned support) {
+		if (MinerUtils::n_conjuncts(pattern) < 2)
+			return 0.0;
+		if (not pattern->getAtomSpace()
+		    and scratch_size < scratch_as->get_size())
+			scratch_as->clear();
+		Handle pat = pattern->getAtomSpace() ? pattern
+			: scratch_as->add_atom(pattern);
+		double ucount = Surprisingness::universe_count(pat, db);
+		TruthValuePtr emp_tv = createSimpleTruthValue(
+			support / ucount, Surprisingness::count_to_confidence(ucount));
+		return Surprisingness::jsd(emp_tv,
+		                           Surprisingness::ji_tv_est_mem(pat, db));
+	};
 }
 
 HandleTree Miner::specialize(const Handle& pattern,
@@ -94,33 +532,44 @@ HandleTree Miner::specialize(const Handle& pattern,
 {
 	// TODO: decide what to choose and remove or comment
 	// return specialize_alt(pattern, db, Valuations(pattern, db), maxdepth);
-	return specialize(pattern, db, Valuations(pattern, db), maxdepth);
+	return specialize(pattern, db,
+	                  get_valuations(pattern, db),
+	                  maxdepth);
 }
 
 HandleTree Miner::specialize(const Handle& pattern,
                              const HandleSeq& db,
                              const Valuations& valuations,
                              int maxdepth)
+{
+	init_search();
+	PatternForest patterns;
+	specialize(pattern, db, valuations, maxdepth, 1, forest_inserter(patterns));
+	return patterns.filter_support(effective_minsup).to_handle_tree();
+}
+
+bool Miner::specialize(const Handle& pattern,
+                       const HandleSeq& db,
+                       const Valuations& valuations,
+                       int maxdepth,
+                       unsigned depth,
+                       const PatternCallback& cb)
 {
 	// One of the termination criteria has been reached
 	if (terminate(pattern, db, valuations, maxdepth))
-		return HandleTree();
+		return true;
 
 	// Produce specializations from other variables than the front
 	// one.
 	valuations.inc_focus_variable();
-	HandleTree patterns = specialize(pattern, db, valuations, maxdepth);
+	bool cont = specialize(pattern, db, valuations, maxdepth, depth, cb);
 	valuations.dec_focus_variable();
+	if (not cont)
+		return false;
 
 	// Produce specializations from shallow abstractions on the front
 	// variable, and so recusively.
-	HandleTree shabs_pats = specialize_shabs(pattern, db, valuations,
-	                                         maxdepth);
-
-	// Merge specializations to patterns while discarding duplicates
-	patterns = merge_patterns({patterns, shabs_pats});
-
-	return patterns;
+	return specialize_shabs(pattern, db, valuations, maxdepth, depth, cb);
 }
 
 HandleTree Miner::specialize_alt(const Handle& pattern,
@@ -132,27 +581,412 @@ HandleTree Miner::specialize_alt(const Handle& pattern,
 	if (terminate(pattern, db, valuations, maxdepth))
 		return HandleTree();
 
-	HandleTree patterns;
+	init_search();
+	PatternForest patterns;
+	PatternCallback cb = forest_inserter(patterns);
 	Variables vars = MinerUtils::get_variables(pattern);
 
 	// Calculate all shallow abstractions of pattern
 	// No type support for cpp-miner.
-	HandleSetSeq shabs = MinerUtils::shallow_abstract(valuations, param.minsup, false, false, {});
+	HandleSetSeq shabs = MinerUtils::shallow_abstract(valuations, effective_minsup, false, false, {});
 
 	// Generate all associated specializations
 	for (unsigned i = 0; i < shabs.size(); i++) {
 		for (const Handle& shapat : shabs[i]) {
 			// Compose pattern with shapat to obtain a specialization,
 			// and recursively specialize the result
-			HandleTree npats = specialize_shapat(pattern, db,
-			                                     vars.varseq[i], shapat,
-			                                     maxdepth);
+			specialize_shapat(pattern, db, vars.varseq[i], shapat,
+			                  maxdepth, 1, cb);
+		}
+	}
+	return patterns.filter_support(effective_minsup).to_handle_tree();
+}
+
+void Miner::init_search()
+{
+	effective_minsup = param.minsup;
+	top_supports = decltype(top_supports)();
+	top_patterns.clear();
+	start_time = std::chrono::steady_clock::now();
+	budget_exhausted = false;
+	budget_checks = 0;
+	passed = PatternForest();
+	deduplicating = false;
+	explored.clear();
+	checkpointing = false;
+	resumed_index.clear();
+}
+
+void Miner::mine(const HandleSeq& db,
+                 const Valuations& valuations,
+                 const PatternCallback& cb)
+{
+	init_search();
+
+	// Record the passed patterns to expand them afterwards
+	PatternCallback rcb = cb;
+	if (1 < param.maximum_conjuncts) {
+		PatternCallback inserter = forest_inserter(passed);
+		rcb = [&cb, inserter](const Handle& pattern, unsigned support,
+		                      unsigned depth) {
+			return cb(pattern, support, depth) and
+				inserter(pattern, support, depth);
+		};
+	}
+
+	bool cont = true;
+	if (param.score) {
+		if (not param.checkpoint_file.empty())
+			LAZY_MINER_LOG_WARN << "Checkpoints are not supported by "
+			                    << "best-first search, ignore "
+			                    << param.checkpoint_file;
+		cont = specialize_best_first(db, valuations, rcb);
+	} else {
+		init_checkpoint(db);
+		cont = specialize(param.initpat, db, valuations, param.maxdepth, 1, rcb);
+		save_checkpoint(true);
+		checkpointing = false;
+	}
 
-			// Insert specializations
-			patterns = merge_patterns({patterns, npats});
+	if (cont and 1 < param.maximum_conjuncts)
+		expand_conjunctions(db, rcb);
+}
+
+bool Miner::expand_conjunctions(const HandleSeq& db, const PatternCallback& cb)
+{
+	// Expanded patterns are never found by the resumed search
+	resumed_index.clear();
+	deduplicating = true;
+	for (unsigned i = 0; i < passed.size(); i++)
+		explored.insert(passed.pattern(i)->get_hash());
+
+	// Unary patterns to expand with, all found before any expansion
+	HandleSeq unaries;
+	for (unsigned i = 0; i < passed.size(); i++)
+		if (MinerUtils::n_conjuncts(passed.pattern(i)) == 1)
+			unaries.push_back(passed.pattern(i));
+
+	// Expand the passed patterns, including the expansions and their
+	// specializations passed meanwhile, till none is left.
+	bool cont = true;
+	for (unsigned i = 0; cont and i < passed.size(); i++) {
+		Handle pattern = passed.pattern(i);
+		if (param.maximum_conjuncts <= MinerUtils::n_conjuncts(pattern))
+			continue;
+
+		// The expansions and their specializations at that depth are
+		// children of pattern.
+		unsigned depth = passed.depth(i) + 2;
+		PatternCallback ecb = [&](const Handle& npat, unsigned support,
+		                          unsigned ndepth) {
+			explicit_parent = ndepth == depth;
+			parent_index = i;
+			bool ncont = cb(npat, support, ndepth);
+			explicit_parent = false;
+			return ncont;
+		};
+
+		for (const Handle& unary : unaries) {
+			HandleSet npats = MinerUtils::expand_conjunction(
+				pattern, unary, db, effective_minsup,
+				std::min(param.maximum_variables, param.maximum_cnjexp_variables),
+				param.enforce_specialization);
+			for (const Handle& npat : npats) {
+				if (not within_budget())
+					return false;
+				if (not explored.insert(npat->get_hash()).second)
+					continue;
+
+				// Like specialize_shapat but without jumping to a
+				// specialization of equal support if not closed, as
+				// it will be explored anyway.
+				Valuations nvals = get_valuations(npat, db);
+				Handle cvar, cshapat;
+				bool output = is_output(npat, nvals, cvar, cshapat);
+				if (output)
+					update_top_k(npat, nvals.size());
+				if (nvals.size() < effective_minsup)
+					continue;
+				if (output and not ecb(npat, nvals.size(), depth))
+					return false;
+				cont = specialize(npat, db, nvals, param.maxdepth,
+				                  output ? depth + 1 : depth, ecb);
+				if (not cont)
+					break;
+			}
+			if (not cont)
+				break;
 		}
 	}
-	return patterns;
+	deduplicating = false;
+	return cont;
+}
+
+bool Miner::Candidate::operator<(const Candidate& other) const
+{
+	// Lower priority if lower score or, if equal, inserted later
+	return score < other.score or (score == other.score and rank > other.rank);
+}
+
+bool Miner::specialize_best_first(const HandleSeq& db,
+                                  const Valuations& valuations,
+                                  const PatternCallback& cb)
+{
+	passed_count = 0;
+	Frontier frontier;
+	if (not terminate(param.initpat, db, valuations, param.maxdepth))
+		push_shabs(frontier, param.initpat, db, valuations, param.maxdepth,
+		           1, PatternForest::npos);
+
+	bool cont = true;
+	while (cont and not frontier.empty() and within_budget()) {
+		Candidate cdt = frontier.top();
+		frontier.pop();
+
+		// The effective minimum support may have risen since
+		if (cdt.support < effective_minsup)
+			continue;
+
+		unsigned index = cdt.parent;
+		if (cdt.output) {
+			explicit_parent = true;
+			parent_index = cdt.parent;
+			cont = cb(cdt.pattern, cdt.support, cdt.depth);
+			explicit_parent = false;
+			index = passed_count++;
+		}
+
+		Valuations vals = get_valuations(cdt.pattern, db);
+		if (cont and not terminate(cdt.pattern, db, vals, cdt.maxdepth))
+			push_shabs(frontier, cdt.pattern, db, vals, cdt.maxdepth,
+			           cdt.output ? cdt.depth + 1 : cdt.depth, index);
+	}
+	parent_index = PatternForest::npos;
+	return cont and not budget_exhausted;
+}
+
+void Miner::push_shabs(Frontier& frontier,
+                       const Handle& pattern,
+                       const HandleSeq& db,
+                       const Valuations& valuations,
+                       int maxdepth,
+                       unsigned depth,
+                       unsigned parent)
+{
+	// Like specialize, go over all variables, then restore the focus
+	unsigned n_inc = 0;
+	for (; not valuations.no_focus(); valuations.inc_focus_variable(), n_inc++) {
+		HandleSet shapats = MinerUtils::focus_shallow_abstract(valuations, effective_minsup, false, false,
+		                                                       param.approx_shallow_abstract);
+		Handle var = valuations.focus_variable();
+		for (const Handle& shapat : shapats)
+			push_shapat(frontier, pattern, db, var, shapat, maxdepth, depth, parent);
+	}
+	for (; 0 < n_inc; n_inc--)
+		valuations.dec_focus_variable();
+}
+
+void Miner::push_shapat(Frontier& frontier,
+                        const Handle& pattern,
+                        const HandleSeq& db,
+                        const Handle& var,
+                        const Handle& shapat,
+                        int maxdepth,
+                        unsigned depth,
+                        unsigned parent)
+{
+	// Like specialize_shapat, but push npat instead of specializing
+	// it recursively
+	Handle npat = nameserver().isA(shapat->get_type(), VARIABLE_NODE) ?
+	              MinerUtils::compose_nocheck(pattern, {var, shapat}) :
+	              MinerUtils::compose(pattern, {{var, shapat}});
+	if (MinerUtils::n_conjuncts(npat) < param.initconjuncts or
+	    param.maximum_variables < MinerUtils::get_variables(npat).size())
+		return;
+	if (not enough_support(npat, db))
+		return;
+
+	Valuations nvals = get_valuations(npat, db);
+	Handle cvar, cshapat;
+	bool output = is_output(npat, nvals, cvar, cshapat);
+	if (cshapat) {
+		if (maxdepth != 1)
+			push_shapat(frontier, npat, db, cvar, cshapat, maxdepth - 1,
+			            depth, parent);
+		return;
+	}
+
+	unsigned support = nvals.size();
+	if (output)
+		update_top_k(npat, support);
+	if (support < effective_minsup)
+		return;
+
+	unsigned rank = frontier.size();
+	frontier.push({npat, support, param.score(npat, support), maxdepth - 1,
+	               depth, parent, output, rank});
+}
+
+void Miner::update_top_k(const Handle& pattern, unsigned support)
+{
+	if (param.top_k == 0 or not top_patterns.insert(pattern->get_hash()).second)
+		return;
+
+	top_supports.push(support);
+	if (param.top_k < top_supports.size())
+		top_supports.pop();
+	if (param.top_k == top_supports.size())
+		effective_minsup = std::max(effective_minsup, top_supports.top());
+}
+
+bool Miner::within_budget()
+{
+	if (budget_exhausted)
+		return false;
+
+	if (0 < param.time_budget) {
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start_time;
+		if (param.time_budget < elapsed.count()) {
+			LAZY_MINER_LOG_INFO << "Miner time budget of "
+			                    << param.time_budget << "s exhausted";
+			budget_exhausted = true;
+		}
+	}
+
+	// Reading the resident memory is comparatively costly, only do it
+	// every so often
+	if (0 < param.memory_budget and budget_checks++ % 64 == 0) {
+		size_t memory = MinerUtils::resident_memory();
+		if (param.memory_budget < memory) {
+			LAZY_MINER_LOG_INFO << "Miner memory budget of "
+			                    << param.memory_budget << " bytes exhausted ("
+			                    << memory << " bytes resident)";
+			budget_exhausted = true;
+		}
+	}
+
+	return not budget_exhausted;
+}
+
+void Miner::init_checkpoint(const HandleSeq& db)
+{
+	checkpoint.clear();
+	checkpoint_path.clear();
+	resumed.clear();
+	resumed_index.clear();
+	checkpointing = not param.checkpoint_file.empty();
+	if (not checkpointing)
+		return;
+
+	// Parameters affecting the results
+	checkpoint.parameters["minsup"] = std::to_string(param.minsup);
+	checkpoint.parameters["initpat"] = MinerCheckpoint::encode_atom(param.initpat);
+	checkpoint.parameters["maxdepth"] = std::to_string(param.maxdepth);
+	checkpoint.parameters["output_mode"] = std::to_string(param.output_mode);
+	checkpoint.parameters["top_k"] = std::to_string(param.top_k);
+	checkpoint.parameters["maximum_conjuncts"] =
+		std::to_string(param.maximum_conjuncts);
+	checkpoint.parameters["maximum_variables"] =
+		std::to_string(param.maximum_variables);
+	checkpoint.parameters["maximum_spcial_conjuncts"] =
+		std::to_string(param.maximum_spcial_conjuncts);
+	checkpoint.parameters["maximum_cnjexp_variables"] =
+		std::to_string(param.maximum_cnjexp_variables);
+	checkpoint.parameters["enforce_specialization"] =
+		std::to_string(param.enforce_specialization);
+	checkpoint.parameters["score"] = param.score ? "best-first" : "depth-first";
+	checkpoint.parameters["db"] = std::to_string(MinerCache::fingerprint(db));
+	checkpoint_time = std::chrono::steady_clock::now();
+
+	if (not MinerCheckpoint::exists(param.checkpoint_file))
+		return;
+
+	resumed.load(param.checkpoint_file);
+	for (const auto& prm : checkpoint.parameters) {
+		const std::string& value = resumed.parameters[prm.first];
+		size_t pos = 0;
+		// The initial pattern may differ by its variable names
+		bool same = prm.first == "initpat" ?
+			content_eq(MinerCheckpoint::decode_atom(value, pos), param.initpat)
+			: value == prm.second;
+		if (not same)
+			throw RuntimeException(TRACE_INFO,
+			                       "Checkpoint %s has a different %s parameter",
+			                       param.checkpoint_file.c_str(),
+			                       prm.first.c_str());
+	}
+	for (unsigned i = 0; i < resumed.patterns.size(); i++)
+		if (resumed.completed[i])
+			resumed_index.insert({resumed.patterns.pattern(i)->get_hash(), i});
+
+	LAZY_MINER_LOG_INFO << "Resume mining from checkpoint "
+	                    << param.checkpoint_file << " with "
+	                    << resumed.patterns.size() << " patterns";
+}
+
+void Miner::save_checkpoint(bool force)
+{
+	if (not checkpointing)
+		return;
+
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - checkpoint_time;
+	if (not force and elapsed.count() < param.checkpoint_interval)
+		return;
+
+	checkpoint.save(param.checkpoint_file);
+	checkpoint_time = std::chrono::steady_clock::now();
+}
+
+void Miner::checkpoint_begin(const Handle& pattern, unsigned support)
+{
+	if (not checkpointing)
+		return;
+
+	unsigned parent = checkpoint_path.empty() ?
+		PatternForest::npos : checkpoint_path.back();
+	checkpoint_path.push_back(checkpoint.add(pattern, support, parent));
+}
+
+void Miner::checkpoint_end(bool completed)
+{
+	if (not checkpointing)
+		return;
+
+	checkpoint.completed[checkpoint_path.back()] = completed;
+	checkpoint_path.pop_back();
+}
+
+unsigned Miner::find_resumed(const Handle& pattern, unsigned depth) const
+{
+	auto range = resumed_index.equal_range(pattern->get_hash());
+	for (auto it = range.first; it != range.second; ++it)
+		if (resumed.patterns.depth(it->second) + 1 == depth and
+		    content_eq(resumed.patterns.pattern(it->second), pattern))
+			return it->second;
+	return PatternForest::npos;
+}
+
+bool Miner::replay(unsigned i, unsigned depth, const PatternCallback& cb)
+{
+	const Handle& pattern = resumed.patterns.pattern(i);
+	unsigned support = resumed.patterns.support(i);
+	update_top_k(pattern, support);
+	if (support < effective_minsup)
+		return true;
+
+	if (not cb(pattern, support, depth))
+		return false;
+
+	checkpoint_begin(pattern, support);
+	bool cont = true;
+	for (unsigned c = resumed.patterns.first_child(i);
+	     cont and c != PatternForest::npos;
+	     c = resumed.patterns.next_sibling(c))
+		cont = replay(c, depth + 1, cb);
+	checkpoint_end(cont);
+	return cont;
 }
 
 bool Miner::terminate(const Handle& pattern,
@@ -167,69 +1001,206 @@ bool Miner::terminate(const Handle& pattern,
 		pattern->get_type() != LAMBDA_LINK or
 		// There is no more variable to specialize from
 		valuations.no_focus() or
+		// The pattern has too many conjuncts to be specialized
+		param.maximum_spcial_conjuncts < MinerUtils::n_conjuncts(pattern) or
 		// The pattern doesn't have enough support
-		not MinerUtils::enough_support(pattern, db, param.minsup);
+		not enough_support(pattern, db);
 }
 
-HandleTree Miner::specialize_shabs(const Handle& pattern,
-                                   const HandleSeq& db,
-                                   const Valuations& valuations,
-                                   int maxdepth)
+bool Miner::specialize_shabs(const Handle& pattern,
+                             const HandleSeq& db,
+                             const Valuations& valuations,
+                             int maxdepth,
+                             unsigned depth,
+                             const PatternCallback& cb)
 {
 	// Generate shallow patterns of the first variable of the
 	// valuations and associate the remaining valuations (excluding
 	// that variable) to them.
 	// No type and glob support for cpp-miner
-	HandleSet shapats = MinerUtils::focus_shallow_abstract(valuations, param.minsup, false, false);
-
-	// No shallow abstraction to use for specialization
-	if (shapats.empty())
-		return HandleTree();
+	HandleSet shapats = MinerUtils::focus_shallow_abstract(valuations, effective_minsup, false, false,
+	                                                       param.approx_shallow_abstract);
 
 	// For each shallow abstraction, create a specialization from
 	// pattern by composing it, and recursively specialize the result
 	// with the new resulting valuations.
-	HandleTree patterns;
 	Handle var = valuations.focus_variable();
 	for (const auto& shapat : shapats)
 	{
 		// Specialize pattern by composing it with shapat, and
 		// specialize the result recursively
-		HandleTree npats
-			= specialize_shapat(pattern, db, var, shapat, maxdepth);
-
-		// Insert specializations
-		patterns = merge_patterns({patterns, npats});
+		if (not specialize_shapat(pattern, db, var, shapat, maxdepth, depth, cb))
+			return false;
 	}
-	return patterns;
+	return true;
 }
 
-HandleTree Miner::specialize_shapat(const Handle& pattern,
-                                    const HandleSeq& db,
-                                    const Handle& var,
-                                    const Handle& shapat,
-                                    int maxdepth)
+bool Miner::specialize_shapat(const Handle& pattern,
+                              const HandleSeq& db,
+                              const Handle& var,
+                              const Handle& shapat,
+                              int maxdepth,
+                              unsigned depth,
+                              const PatternCallback& cb)
 {
+	// Stop the search altogether if out of budget
+	if (not within_budget())
+		return false;
+	save_checkpoint();
+
 	// Perform the composition (that is specialize)
 
 	Handle npat = nameserver().isA(shapat->get_type(), VARIABLE_NODE) ?
 	              MinerUtils::compose_nocheck(pattern, {var, shapat}) :
 	              MinerUtils::compose(pattern, {{var, shapat}});
 
-	// If the specialization has too few conjuncts, dismiss it.
-	if (MinerUtils::n_conjuncts(npat) < param.initconjuncts)
-		return HandleTree();
+	// If the specialization has too few conjuncts or too many
+	// variables, dismiss it.
+	if (MinerUtils::n_conjuncts(npat) < param.initconjuncts or
+	    param.maximum_variables < MinerUtils::get_variables(npat).size())
+		return true;
+
+	// npat has already been explored from another path
+	if (deduplicating and not explored.insert(npat->get_hash()).second)
+		return true;
+
+	// npat and its specializations have already been found by the
+	// resumed search, pass them along.
+	if (not resumed_index.empty()) {
+		unsigned i = find_resumed(npat, depth);
+		if (i != PatternForest::npos)
+			return replay(i, depth, cb);
+	}
 
 	// That specialization doesn't have enough support, skip it
 	// and its specializations.
-	if (not MinerUtils::enough_support(npat, db, param.minsup))
-		return HandleTree();
+	if (not enough_support(npat, db))
+		return true;
+
+	// The valuations of npat are needed to specialize it anyway, and
+	// provide its exact support.
+	Valuations nvals = get_valuations(npat, db);
+
+	Handle cvar, cshapat;
+	bool output = is_output(npat, nvals, cvar, cshapat);
+
+	// npat is not closed, all closed or maximal patterns below it are
+	// below its specialization of equal support, only explore that
+	// one, if within maxdepth.
+	if (cshapat)
+		return maxdepth == 1 or
+			specialize_shapat(npat, db, cvar, cshapat, maxdepth - 1, depth, cb);
+
+	// Account for npat in the top k patterns, which may raise the
+	// effective minimum support above its own, in which case neither
+	// npat nor its specializations are part of the top k patterns.
+	if (output)
+		update_top_k(npat, nvals.size());
+	if (nvals.size() < effective_minsup)
+		return true;
+
+	// Pass npat before its specializations
+	if (output and not cb(npat, nvals.size(), depth))
+		return false;
 
 	// Specialize npat from all variables (with new valuations)
-	HandleTree nvapats = specialize(npat, db, maxdepth - 1);
+	if (output)
+		checkpoint_begin(npat, nvals.size());
+	bool cont = specialize(npat, db, nvals, maxdepth - 1,
+	                       output ? depth + 1 : depth, cb);
+	if (output)
+		checkpoint_end(cont);
+	return cont;
+}
+
+bool Miner::is_output(const Handle& pattern,
+                      const Valuations& valuations,
+                      Handle& var,
+                      Handle& shapat) const
+{
+	if (param.output_mode == MinerParameters::ALL)
+		return true;
+
+	// Look for a shallow abstraction of equal support
+	const Variables& vars = MinerUtils::get_variables(pattern);
+	HandleSetSeq shabs = MinerUtils::shallow_abstract(valuations,
+	                                                  valuations.size(),
+	                                                  false, false, {});
+	for (unsigned i = 0; i < shabs.size(); i++) {
+		if (not shabs[i].empty()) {
+			var = vars.varseq[i];
+			shapat = *shabs[i].begin();
+			return false;
+		}
+	}
+
+	return param.output_mode == MinerParameters::CLOSED or
+		MinerUtils::is_maximal(valuations, effective_minsup);
+}
+
+PatternCallback Miner::forest_inserter(PatternForest& patterns) const
+{
+	// Index of the last added pattern at each depth, the last one at
+	// depth-1 being the parent of a pattern at depth.
+	auto parents = std::make_shared<std::vector<unsigned>>();
+	return [this, &patterns, parents](const Handle& pattern, unsigned support,
+	                                  unsigned depth) {
+		parents->resize(depth - 1);
+		unsigned parent = explicit_parent ? parent_index
+			: parents->empty() ? PatternForest::npos : parents->back();
+		parents->push_back(patterns.add(pattern, support, parent));
+		return true;
+	};
+}
 
-	// Return npat and its children
-	return HandleTree(npat, {nvapats});
+PatternCallback Miner::lattice_inserter(PatternLattice& lattice,
+                                        unsigned top) const
+{
+	// Lattice index of the last passed pattern at each depth, like in
+	// forest_inserter, and, if parents may be explicitly given, of
+	// each passed pattern, as parent indices refer to the order
+	// patterns are passed. npos stands for a pattern not added,
+	// whose specializations are not added either, as they cannot
+	// have a higher support.
+	auto parents = std::make_shared<std::vector<unsigned>>();
+	auto passed_indices = std::make_shared<std::vector<unsigned>>();
+	bool record_passed = param.score or 1 < param.maximum_conjuncts;
+	return [this, &lattice, top, parents, passed_indices, record_passed]
+		(const Handle& pattern, unsigned support, unsigned depth) {
+		parents->resize(depth - 1);
+		unsigned parent = not explicit_parent ?
+			(parents->empty() ? top : parents->back())
+			: parent_index == PatternForest::npos ? top
+			: (*passed_indices)[parent_index];
+		unsigned i = parent == PatternLattice::npos
+			or support < effective_minsup ? PatternLattice::npos
+			: lattice.add(pattern, support, parent);
+		parents->push_back(i);
+		if (record_passed)
+			passed_indices->push_back(i);
+		return true;
+	};
+}
+
+Valuations Miner::get_valuations(const Handle& pattern,
+                                 const HandleSeq& db) const
+{
+	if (weights)
+		return Valuations(pattern, *weights, param.valuations_chunk_size);
+	if (db_view)
+		return Valuations(pattern, *db_view, param.valuations_chunk_size);
+	return Valuations(pattern, db, param.valuations_chunk_size, param.jobs,
+	                  param.approx_shallow_abstract);
+}
+
+bool Miner::enough_support(const Handle& pattern, const HandleSeq& db) const
+{
+	if (weights)
+		return effective_minsup <= MinerUtils::support(pattern, *weights,
+		                                               effective_minsup);
+	if (db_view)
+		return effective_minsup <= get_valuations(pattern, db).size();
+	return MinerUtils::enough_support(pattern, db, effective_minsup, param.jobs);
 }
 
 } // namespace opencog
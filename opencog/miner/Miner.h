@@ -28,7 +28,16 @@
 #include <opencog/atoms/core/RewriteLink.h>
 #include <opencog/atomspace/AtomSpace.h>
 
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "HandleTree.h"
+#include "MinerCheckpoint.h"
+#include "PatternForest.h"
+#include "PatternLattice.h"
 #include "Valuations.h"
 #include "MinerUtils.h"
 
@@ -37,6 +46,13 @@ class MinerUTest;
 namespace opencog
 {
 
+/**
+ * Score of a pattern given its support, the greater the more
+ * valuable, see MinerParameters::score.
+ */
+typedef std::function<double(const Handle& pattern,
+                             unsigned support)> PatternScore;
+
 /**
  * Parameters for Miner. The terminology is taken from
  * Frequent Subtree Mining -- An Overview, from Yun Chi et al, when
@@ -44,6 +60,21 @@ namespace opencog
  */
 struct MinerParameters {
 
+	/**
+	 * Which mined patterns are output.
+	 *
+	 * ALL: all patterns reaching minsup.
+	 *
+	 * CLOSED: only patterns without specialization of equal support.
+	 *
+	 * MAXIMAL: only patterns without specialization reaching minsup.
+	 *
+	 * Specializations are those obtained by the miner, that is by
+	 * composing patterns with shallow abstractions, see
+	 * MinerUtils::is_closed and MinerUtils::is_maximal.
+	 */
+	enum OutputMode { ALL, CLOSED, MAXIMAL };
+
 	/**
 	 * CTor. Note that conjuncts will be overwritten by initpat, if
 	 * provided.
@@ -77,8 +108,124 @@ struct MinerParameters {
 	// depth limit. Depth is the number of specializations between the
 	// initial pattern and the produced patterns.
 	int maxdepth;
+
+	// If positive, valuations are streamed by chunks of that many
+	// data trees, only retaining aggregated counters instead of all
+	// groundings, see Valuations. Zero (the default) materializes
+	// all groundings.
+	unsigned valuations_chunk_size;
+
+	// Number of threads over which the support of single conjunct
+	// components is counted, and their valuations built, each
+	// matching shards of the db, see
+	// MinerUtils::sharded_satisfying_set. Defaults to 1, serial.
+	// Sharded valuations are materialized, thus jobs above 1 cannot
+	// be combined with a positive valuations_chunk_size, which the
+	// Miner constructor checks.
+	unsigned jobs;
+
+	// If true, shallow abstractions are pre-counted with a Count-Min
+	// sketch and only those that may reach minsup are built and
+	// exactly counted, see MinerUtils::focus_shallow_abstract. The
+	// mined patterns are the same. Combined with a positive
+	// valuations_chunk_size, the sketches are fed as valuations are
+	// streamed, and only the values passing them are ever counted
+	// exactly, see SCValuations.
+	bool approx_shallow_abstract;
+
+	// Which mined patterns are output, see OutputMode. Defaults to
+	// ALL.
+	OutputMode output_mode;
+
+	// If positive, only mine the top_k most frequent patterns (more
+	// in case of ties). minsup is then only the initial minimum
+	// support, raised to the support of the k-th most frequent output
+	// pattern found so far as the search goes, see
+	// Miner::get_effective_minsup. Zero (the default) disables it.
+	unsigned top_k;
+
+	// If positive, maximum wall-clock time in seconds, respectively
+	// resident memory in bytes of the process, allocated to a
+	// search. Once exceeded the search stops, keeping the patterns
+	// found so far, see Miner::is_budget_exhausted. Zero (the
+	// default) means no budget.
+	double time_budget;
+	size_t memory_budget;
+
+	// If not empty, file where the state of the search is saved every
+	// checkpoint_interval seconds (60 by default) and when it ends,
+	// see MinerCheckpoint. If the file already exists when a search
+	// starts, the search is resumed from it, skipping the
+	// specializations of patterns it has completely explored. The
+	// parameters affecting the results and the db of the checkpoint
+	// must then be the same. Only
+	// supported by Miner::operator(), Miner::mine_forest and
+	// Miner::mine_lattice.
+	std::string checkpoint_file;
+	double checkpoint_interval;
+
+	// If set, the search is best-first instead of depth-first, the
+	// frontier of patterns to specialize being a priority queue
+	// ordered by that score, see Miner::support_score,
+	// Miner::conjuncts_score and Miner::surprisingness_score, so
+	// that, under a budget, the most valuable patterns are found
+	// first. Checkpoints are not supported in that mode. Unset by
+	// default.
+	PatternScore score;
+
+	// If above 1, after specializing param.initpat, expand the
+	// patterns found with fewer than maximum_conjuncts conjuncts by
+	// conjunction with the unary patterns found, like the conjunction
+	// expansion rule of cog-mine, see MinerUtils::expand_conjunction,
+	// then specialize and expand these expansions in turn. If
+	// enforce_specialization is true (the default), only expansions
+	// not introducing new variables are considered. Defaults to 1,
+	// no conjunction expansion.
+	unsigned maximum_conjuncts;
+	bool enforce_specialization;
+
+	// Maximum number of variables of the mined patterns, patterns
+	// with more variables are dismissed along with their
+	// specializations, respectively of the conjunction expansions.
+	// Both default to UINT_MAX.
+	unsigned maximum_variables;
+	unsigned maximum_cnjexp_variables;
+
+	// Maximum number of conjuncts of the patterns to specialize, as
+	// specializing conjunctions can be very expensive. Conjunctions
+	// with more conjuncts may still be expanded. Defaults to
+	// UINT_MAX.
+	unsigned maximum_spcial_conjuncts;
 };
 
+/**
+ * Callback called by Miner on each mined pattern as soon as it is
+ * found, with its support and depth, that is the number of
+ * specializations between the initial pattern and it (thus at least
+ * 1), only counting output patterns if MinerParameters::output_mode
+ * is not ALL. Patterns are passed in depth-first pre-order, a pattern
+ * is always passed before its specializations. Return false to stop
+ * mining.
+ *
+ * If MinerParameters::score is set, patterns are passed in best-first
+ * order instead, still after their parents, which are then given by
+ * Miner::get_parent_index.
+ *
+ * If MinerParameters::top_k is positive, a pattern may be passed
+ * before the effective minimum support rises above its support, such
+ * patterns are not part of the top k patterns and are to be discarded
+ * by the caller, see Miner::get_effective_minsup.
+ */
+typedef std::function<bool(const Handle& pattern,
+                           unsigned support,
+                           unsigned depth)> PatternCallback;
+
+/**
+ * Updated support of a unary pattern previously mined, see
+ * Miner::mine_incremental.
+ */
+typedef std::function<unsigned(const Handle& pattern)> UnarySupport;
+
 /**
  * Experimental pattern miner. Mined patterns should be compatible
  * with the pattern matcher, that is if feed to the pattern matcher,
@@ -108,6 +255,191 @@ public:
 	 */
 	HandleTree operator()(const HandleSeq& db);
 
+	/**
+	 * Like above but, instead of returning a tree of patterns, pass
+	 * each pattern to cb as soon as it is found, see
+	 * PatternCallback. No pattern is retained by the miner, so that
+	 * results can be streamed by the caller.
+	 */
+	void operator()(const AtomSpace& db_as, const PatternCallback& cb);
+	void operator()(const HandleSeq& db, const PatternCallback& cb);
+
+	/**
+	 * Like operator() but return the patterns as a PatternForest,
+	 * holding their supports as well.
+	 */
+	PatternForest mine_forest(const AtomSpace& db_as);
+	PatternForest mine_forest(const HandleSeq& db);
+
+	/**
+	 * Like mine_forest over a weighted db, see MinerUtils::weigh_db,
+	 * each valuation counting as its weight, so that the patterns
+	 * and supports are those over the db where each data tree occurs
+	 * as many times as its multiplicity, as distinct data trees,
+	 * while only going through the distinct ones.
+	 */
+	PatternForest mine_forest(const HandleUCounter& wdb);
+
+	/**
+	 * Like mine_forest over a view of a db, such as that of a
+	 * DbSnapshot (see DbSnapshot::view), the valuations of each
+	 * pattern being streamed, param.valuations_chunk_size data trees
+	 * at a time, so that the whole db is never held in memory at
+	 * once, at the cost of materializing its data trees again for
+	 * each pattern. Conjunction expansion, checkpoints and several
+	 * jobs are not supported.
+	 */
+	PatternForest mine_forest(const DbView& db);
+
+	/**
+	 * Like operator() but return the patterns as a PatternLattice,
+	 * where each pattern is stored once, with an edge to each pattern
+	 * it has been obtained from. Unlike the other variants the
+	 * initial pattern is included, as the top of the lattice.
+	 */
+	PatternLattice mine_lattice(const AtomSpace& db_as);
+	PatternLattice mine_lattice(const HandleSeq& db);
+
+	/**
+	 * Incrementally update patterns, mined by this miner over a db,
+	 * given the data trees delta since added to it, and optionally
+	 * the data trees removed from it, db being the updated db,
+	 * including delta. Return the previous patterns with their
+	 * updated supports, followed by the newly frequent patterns,
+	 * under the pattern they specialize, without the patterns that
+	 * no longer reach the minimum support.
+	 *
+	 * The support of a unary pattern is incremented by the number of
+	 * its groundings over delta that are not subtrees of the previous
+	 * db, and decremented by the number of its groundings over
+	 * removed that are not subtrees of db, so that groundings shared
+	 * by several data trees are counted once, while the support of a
+	 * totally abstract pattern, or a conjunction, whose valuations may span
+	 * several data trees, is calculated again. Removing data trees
+	 * cannot increase supports, thus new patterns are searched among
+	 * the shallow
+	 * specializations of the previous patterns (and param.initpat)
+	 * occurring in delta, the only ones that may have newly reached
+	 * param.minsup, and specialized as usual from there, maxdepth
+	 * being counted from the depth of the previous patterns in the
+	 * forest.
+	 *
+	 * Only supported with the ALL output mode, without top-k nor
+	 * conjunction expansion.
+	 */
+	PatternForest mine_incremental(const PatternForest& patterns,
+	                               const HandleSeq& db,
+	                               const HandleSeq& delta,
+	                               const HandleSeq& removed=HandleSeq());
+
+	/**
+	 * Like mine_incremental but the updated supports of the previous
+	 * unary patterns, except totally abstract ones, are given by
+	 * unary_support, for callers maintaining them otherwise, such as
+	 * WindowMiner.
+	 */
+	PatternForest mine_incremental(const PatternForest& patterns,
+	                               const HandleSeq& db,
+	                               const HandleSeq& delta,
+	                               const HandleSeq& removed,
+	                               const UnarySupport& unary_support);
+
+	/**
+	 * Given patterns previously mined over db with a minimum support
+	 * greater than param.minsup (from param.initpat, with the ALL
+	 * output mode, exhaustively), return them followed by the
+	 * patterns reaching param.minsup but not the previous minimum
+	 * support, under the pattern they specialize.
+	 *
+	 * The db being the same, the previous patterns keep their
+	 * supports, and their specializations have already been explored
+	 * down to the previous minimum support, thus only the shallow
+	 * specializations of the previous patterns (and param.initpat)
+	 * that are not previous patterns themselves, the frontier pruned
+	 * by the previous search, are explored, and specialized as usual
+	 * from there, maxdepth being counted from the depth of the
+	 * previous patterns in the forest. This allows to lower the
+	 * minimum support progressively without mining from scratch.
+	 *
+	 * Only supported with the ALL output mode, without top-k nor
+	 * conjunction expansion.
+	 */
+	PatternForest mine_warm_start(const PatternForest& patterns,
+	                              const HandleSeq& db);
+
+	/**
+	 * Two-phase sample-then-verify mining, after Toivonen. First mine
+	 * a random sample of sample_size data trees of db (see
+	 * Surprisingness::subsmp) with param.minsup scaled to the sample
+	 * size and lowered by the factor lowering, to reduce the chance
+	 * of missing patterns frequent in db. Then compute the negative
+	 * border from the sample, that is the shallow specializations of
+	 * the candidates (and param.initpat) occurring in the sample that
+	 * are not candidates themselves. The candidates and the border
+	 * are then checked over db in one batched pass, see
+	 * MinerUtils::supports, keeping the candidates reaching
+	 * param.minsup (with their supports over db). Only the border
+	 * patterns reaching param.minsup are added, under the pattern
+	 * they specialize, and specialized as usual over db from there.
+	 *
+	 * If no border pattern reaches param.minsup, the sample is deemed
+	 * to have found all patterns, see is_sample_complete. As the
+	 * border is computed from the sample, patterns not occurring in
+	 * the sample below a border pattern that is not frequent in db
+	 * are not found, which lowering the minimum support over the
+	 * sample makes unlikely.
+	 *
+	 * Only supported with the ALL output mode, without top-k nor
+	 * conjunction expansion.
+	 */
+	PatternForest mine_sample(const HandleSeq& db, unsigned sample_size,
+	                          double lowering=0.8);
+
+	/**
+	 * Return the minimum support effectively used by the last search,
+	 * that is param.minsup unless param.top_k is positive, in which
+	 * case it is the support of the k-th most frequent pattern found
+	 * (or param.minsup if fewer patterns were found).
+	 */
+	unsigned get_effective_minsup() const;
+
+	/**
+	 * Return true iff the last search has been stopped because its
+	 * time or memory budget has been exhausted, see
+	 * MinerParameters::time_budget and MinerParameters::memory_budget,
+	 * in which case only the patterns found so far have been
+	 * returned.
+	 */
+	bool is_budget_exhausted() const;
+
+	/**
+	 * Return true iff no pattern of the negative border checked by
+	 * the last mine_sample reaches the minimum support over db, that
+	 * is the mined sample alone has found the frequent patterns of
+	 * db.
+	 */
+	bool is_sample_complete() const;
+
+	/**
+	 * In best-first mode, see MinerParameters::score, return the
+	 * index, in the order patterns are passed to the callback, of the
+	 * parent of the pattern being passed, or PatternForest::npos if
+	 * it has none.
+	 */
+	unsigned get_parent_index() const;
+
+	/**
+	 * Scores for MinerParameters::score, preferring patterns with
+	 * higher support, more conjuncts, respectively higher estimated
+	 * surprisingness w.r.t. db, that is the Jensen-Shannon distance
+	 * between the empirical truth value of the pattern and its
+	 * estimate assuming its conjuncts are independent, see
+	 * Surprisingness::ji_tv_est (0 for single conjunct patterns).
+	 */
+	static PatternScore support_score();
+	static PatternScore conjuncts_score();
+	static PatternScore surprisingness_score(const HandleSeq& db);
+
 	/**
 	 * Specialization. Given a pattern and a collection of data trees,
 	 * generate all specialized patterns of the given pattern.
@@ -140,9 +472,230 @@ private:
 
 	mutable AtomSpacePtr tmp_as;
 
+	// Effective minimum support, see get_effective_minsup
+	unsigned effective_minsup;
+
+	// Weighted db being mined, if any, see mine_forest(const
+	// HandleUCounter&), nullptr otherwise
+	const HandleUCounter* weights;
+
+	// View of the db being mined, if any, see mine_forest(const
+	// DbView&), nullptr otherwise
+	const DbView* db_view;
+
+	// Supports of the k most frequent patterns found so far, and the
+	// hashes of the patterns already counted, to not count twice a
+	// pattern reached by different specialization paths.
+	std::priority_queue<unsigned, std::vector<unsigned>,
+	                    std::greater<unsigned>> top_supports;
+	std::unordered_set<ContentHash> top_patterns;
+
+	// Start time of the search, whether its budget is exhausted, and
+	// number of budget checks so far, used to only check memory
+	// periodically.
+	std::chrono::steady_clock::time_point start_time;
+	bool budget_exhausted;
+	unsigned budget_checks;
+
+	// Whether the last mine_sample was complete, see
+	// is_sample_complete
+	bool sample_complete;
+
+	/**
+	 * Return false iff the time or memory budget is exceeded, in
+	 * which case the search should stop.
+	 */
+	bool within_budget();
+
+	// Checkpoint of the search being resumed, with an index of its
+	// completely explored patterns, and of the current search, with
+	// the indices of the output patterns being explored, from the
+	// root, see MinerParameters::checkpoint_file. Checkpointing only
+	// covers the specialization of param.initpat, not conjunction
+	// expansion, which is done again when resuming.
+	bool checkpointing;
+	MinerCheckpoint resumed;
+	std::unordered_multimap<ContentHash, unsigned> resumed_index;
+	MinerCheckpoint checkpoint;
+	std::vector<unsigned> checkpoint_path;
+	std::chrono::steady_clock::time_point checkpoint_time;
+
+	/**
+	 * If param.checkpoint_file is not empty, start a new checkpoint
+	 * of the search over db and load the one to resume from, if any.
+	 * Throw a RuntimeException if its parameters, or its db, differ.
+	 */
+	void init_checkpoint(const HandleSeq& db);
+
+	/**
+	 * Save the current checkpoint, if param.checkpoint_file is not
+	 * empty and, unless forced, checkpoint_interval seconds have
+	 * elapsed since the last save.
+	 */
+	void save_checkpoint(bool force=false);
+
+	/**
+	 * Add an output pattern to the current checkpoint, under the
+	 * output pattern being explored, before exploring its
+	 * specializations.
+	 */
+	void checkpoint_begin(const Handle& pattern, unsigned support);
+
+	/**
+	 * Mark the output pattern being explored as completed or not,
+	 * after exploring its specializations.
+	 */
+	void checkpoint_end(bool completed);
+
 	/**
-	 * Return true iff maxdepth is null or pattern is not a lambda or
-	 * doesn't have enough support. Additionally the second one check
+	 * Return the index of a completely explored pattern of the
+	 * resumed checkpoint equal to pattern at the given depth, npos if
+	 * none.
+	 */
+	unsigned find_resumed(const Handle& pattern, unsigned depth) const;
+
+	/**
+	 * Pass the completely explored pattern of index i of the resumed
+	 * checkpoint and its specializations to cb, as if they were found
+	 * again, the pattern being at the given depth.
+	 */
+	bool replay(unsigned i, unsigned depth, const PatternCallback& cb);
+
+	/**
+	 * Pattern to specialize in the frontier of the best-first search,
+	 * with its support, score, maximum depth of its specializations,
+	 * depth, parent index (see get_parent_index), whether it is
+	 * output, and insertion rank, to break ties in insertion order.
+	 */
+	struct Candidate
+	{
+		Handle pattern;
+		unsigned support;
+		double score;
+		int maxdepth;
+		unsigned depth;
+		unsigned parent;
+		bool output;
+		unsigned rank;
+		bool operator<(const Candidate& other) const;
+	};
+	typedef std::priority_queue<Candidate> Frontier;
+
+	// Whether the parent index of the pattern being passed to the
+	// callback is explicitly given, in best-first search or
+	// conjunction expansion, that parent index and the number of
+	// patterns passed so far in best-first search.
+	bool explicit_parent;
+	unsigned parent_index;
+	unsigned passed_count;
+
+	/**
+	 * Best-first search, see MinerParameters::score. Specialize the
+	 * initial pattern, pushing its specializations to the frontier,
+	 * then repeatedly pop the best one, pass it to cb and push its
+	 * own specializations. Return false iff cb has requested to stop.
+	 *
+	 * Valuations are not kept in the frontier to save memory, they
+	 * are calculated again when a pattern is popped.
+	 */
+	bool specialize_best_first(const HandleSeq& db,
+	                           const Valuations& valuations,
+	                           const PatternCallback& cb);
+
+	/**
+	 * Push the specializations of the given pattern, with the given
+	 * valuations, to the frontier, see specialize_shabs.
+	 */
+	void push_shabs(Frontier& frontier,
+	                const Handle& pattern,
+	                const HandleSeq& db,
+	                const Valuations& valuations,
+	                int maxdepth,
+	                unsigned depth,
+	                unsigned parent);
+
+	/**
+	 * Push the specialization of the given pattern with the given
+	 * shallow abstraction to the frontier, unless it is pruned, see
+	 * specialize_shapat.
+	 */
+	void push_shapat(Frontier& frontier,
+	                 const Handle& pattern,
+	                 const HandleSeq& db,
+	                 const Handle& var,
+	                 const Handle& shapat,
+	                 int maxdepth,
+	                 unsigned depth,
+	                 unsigned parent);
+
+	// Patterns passed so far, with their parents, if conjunction
+	// expansion is enabled. Whether the search may reach a pattern
+	// by different paths, in conjunction expansion, incremental or
+	// warm start mining, and the hashes of the patterns explored so far in that
+	// case, to not explore a pattern twice.
+	PatternForest passed;
+	bool deduplicating;
+	std::unordered_set<ContentHash> explored;
+
+	/**
+	 * Expand the passed patterns by conjunction, pass the expansions
+	 * to cb and specialize them, see MinerParameters::maximum_conjuncts.
+	 * Return false iff cb has requested to stop or the budget is
+	 * exhausted.
+	 */
+	bool expand_conjunctions(const HandleSeq& db, const PatternCallback& cb);
+
+	/**
+	 * Add to patterns, under parent, the shallow specializations of
+	 * pattern with at least ms occurrences in delta that have newly
+	 * reached the minimum support over db, followed by their
+	 * specializations, down to maxdepth, see mine_incremental and
+	 * mine_warm_start.
+	 */
+	void extend_incremental(PatternForest& patterns,
+	                        unsigned parent,
+	                        const Handle& pattern,
+	                        const HandleSeq& db,
+	                        const HandleSeq& delta,
+	                        unsigned ms,
+	                        int maxdepth);
+
+	/**
+	 * Call fun on each shallow specialization of pattern with at
+	 * least ms occurrences in db, within param.initconjuncts and
+	 * param.maximum_variables, that has not been explored yet, which
+	 * is then marked as explored, see extend_incremental and
+	 * mine_sample.
+	 */
+	void foreach_shallow_specialization(const Handle& pattern,
+	                                    const HandleSeq& db,
+	                                    unsigned ms,
+	                                    const std::function<void(const Handle&)>& fun);
+
+	/**
+	 * Reset the search state, in particular the effective minimum
+	 * support to param.minsup. Called before each search.
+	 */
+	void init_search();
+
+	/**
+	 * Like operator() given the valuations of param.initpat.
+	 */
+	void mine(const HandleSeq& db,
+	          const Valuations& valuations,
+	          const PatternCallback& cb);
+
+	/**
+	 * If param.top_k is positive, account for the given output
+	 * pattern and its support, and raise the effective minimum
+	 * support accordingly.
+	 */
+	void update_top_k(const Handle& pattern, unsigned support);
+
+	/**
+	 * Return true iff maxdepth is null or pattern is not a lambda, has
+	 * more than param.maximum_spcial_conjuncts conjuncts or doesn't
+	 * have enough support. Additionally the second one check
 	 * whether the valuation has any variable left to specialize from.
 	 */
 	bool terminate(const Handle& pattern,
@@ -150,32 +703,91 @@ private:
 	               const Valuations& valuations,
 	               int maxdepth) const;
 
+	/**
+	 * Like specialize but pass the specializations to cb instead of
+	 * returning them, depth being the depth of these
+	 * specializations. Return false iff cb has requested to stop.
+	 */
+	bool specialize(const Handle& pattern,
+	                const HandleSeq& db,
+	                const Valuations& valuations,
+	                int maxdepth,
+	                unsigned depth,
+	                const PatternCallback& cb);
+
 	/**
 	 * Specialize the given pattern according to shallow abstractions
 	 * obtained by looking at the valuations of the front variable of
 	 * valuations, then recursively call Miner::specialize on these
 	 * obtained specializations.
 	 */
-	HandleTree specialize_shabs(const Handle& pattern,
-	                            const HandleSeq& db,
-	                            const Valuations& valuations,
-	                            int maxdepth);
+	bool specialize_shabs(const Handle& pattern,
+	                      const HandleSeq& db,
+	                      const Valuations& valuations,
+	                      int maxdepth,
+	                      unsigned depth,
+	                      const PatternCallback& cb);
 
 	/**
 	 * Specialize the given pattern with the given shallow abstraction
-	 * at the given variable, then call Miner::specialize on the
-	 * obtained specialization.
+	 * at the given variable, pass it to cb if it is to be output
+	 * according to param.output_mode, then call Miner::specialize on
+	 * the obtained specialization.
+	 *
+	 * If param.output_mode is CLOSED or MAXIMAL and the obtained
+	 * specialization has a shallow abstraction of equal support, then
+	 * only the specialization with that shallow abstraction is
+	 * explored, as any closed or maximal pattern below it is below the
+	 * latter as well.
+	 */
+	bool specialize_shapat(const Handle& pattern,
+	                       const HandleSeq& db,
+	                       const Handle& var,
+	                       const Handle& shapat,
+	                       int maxdepth,
+	                       unsigned depth,
+	                       const PatternCallback& cb);
+
+	/**
+	 * Return true iff the pattern with the given valuations is to be
+	 * output according to param.output_mode. If it is not because it
+	 * has a shallow abstraction of equal support, then set var and
+	 * shapat to that variable and shallow abstraction.
+	 */
+	bool is_output(const Handle& pattern,
+	               const Valuations& valuations,
+	               Handle& var,
+	               Handle& shapat) const;
+
+	/**
+	 * Return a callback adding the patterns it is passed to
+	 * patterns, rebuilding the specialization forest from their
+	 * depths, or their parent indices when explicitly given.
+	 */
+	PatternCallback forest_inserter(PatternForest& patterns) const;
+
+	/**
+	 * Like forest_inserter but add the patterns to lattice, as
+	 * specializations of top at depth 1, so that no intermediary
+	 * forest is built. Patterns below the effective minimum support
+	 * are not added.
+	 */
+	PatternCallback lattice_inserter(PatternLattice& lattice,
+	                                 unsigned top) const;
+
+	/**
+	 * Return the valuations of pattern over db, streamed, sharded or
+	 * sketched according to param, see Valuations, or weighted over
+	 * the weighted db if any, or streamed over the db view if any.
 	 */
-	HandleTree specialize_shapat(const Handle& pattern,
-	                             const HandleSeq& db,
-	                             const Handle& var,
-	                             const Handle& shapat,
-	                             int maxdepth);
+	Valuations get_valuations(const Handle& pattern,
+	                          const HandleSeq& db) const;
 
 	/**
 	 * Calculate if the pattern has enough support w.r.t. to the given
 	 * db, that is whether its frequency is greater than or equal
-	 * to minsup.
+	 * to the effective minimum support, over the weighted db or the
+	 * db view if any.
 	 */
 	bool enough_support(const Handle& pattern,
 	                    const HandleSeq& db) const;
@@ -0,0 +1,409 @@
+/*
+ * MinerCache.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MinerCache.h"
+#include "MinerLogger.h"
+#include "MinerUtils.h"
+
+#include <opencog/util/exceptions.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+
+namespace opencog
+{
+
+static const char cache_magic[] = "MINCACHE";
+static const uint32_t cache_version = 2;
+
+// Size of an entry in the file
+static const size_t cache_entry_size = 8 + 8 + 1 + 8 + 8 + 8;
+
+const size_t MinerCache::max_fingerprints = 4;
+
+// Key and node in the hash table, plus the hash table bucket, and
+// key in the recency list, plus its 2 links
+const size_t MinerCache::entry_bytes =
+	sizeof(Key) + sizeof(Node) + 3 * sizeof(void*)
+	+ sizeof(Key) + 2 * sizeof(void*);
+
+double MinerCache::Statistics::hit_rate() const
+{
+	uint64_t lookups = hits + misses;
+	return lookups == 0 ? 0.0 : (double)hits / lookups;
+}
+
+bool MinerCache::Key::operator==(const Key& other) const
+{
+	return db == other.db and pattern == other.pattern and kind == other.kind;
+}
+
+size_t MinerCache::KeyHash::operator()(const Key& key) const
+{
+	return key.pattern ^ (key.db * 31) ^ key.kind;
+}
+
+MinerCache::MinerCache()
+	: _open(false), _capacity(0), _hits(0), _misses(0), _evictions(0) {}
+
+void MinerCache::open(const std::string& filename, const HandleSeq& db,
+                      size_t capacity)
+{
+	close();
+	std::lock_guard<std::mutex> lock(_mutex);
+	db_fingerprint(db);
+	_capacity = capacity;
+	_hits = _misses = _evictions = 0;
+	if (not filename.empty())
+		load(filename);
+	_open = true;
+	_filename = filename;
+	LAZY_MINER_LOG_DEBUG << "Open miner cache " << filename << " with "
+	                     << _entries.size() << " entries";
+}
+
+void MinerCache::close()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (not _open)
+		return;
+	LAZY_MINER_LOG_DEBUG << "Close miner cache " << _filename << " with "
+	                     << _entries.size() << " entries, "
+	                     << _hits << " hits, " << _misses << " misses, "
+	                     << _evictions << " evictions";
+	if (not _filename.empty())
+		write();
+	_open = false;
+	_filename.clear();
+	_entries.clear();
+	_recency.clear();
+	_fingerprints.clear();
+}
+
+bool MinerCache::is_open() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _open;
+}
+
+void MinerCache::save() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (not _filename.empty())
+		write();
+}
+
+size_t MinerCache::size() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _entries.size();
+}
+
+MinerCache::Statistics MinerCache::statistics() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return {_hits, _misses, _evictions, _entries.size(),
+	        _entries.size() * entry_bytes};
+}
+
+uint64_t MinerCache::fingerprint(const HandleSeq& db)
+{
+	std::vector<uint64_t> hashes;
+	hashes.reserve(db.size());
+	for (const Handle& dt : db)
+		hashes.push_back(dt->get_hash());
+	std::sort(hashes.begin(), hashes.end());
+
+	// FNV-1a over the sorted hashes
+	uint64_t fp = 14695981039346656037ULL;
+	for (uint64_t h : hashes)
+		for (unsigned i = 0; i < 8; i++) {
+			fp ^= (h >> (8 * i)) & 0xff;
+			fp *= 1099511628211ULL;
+		}
+	return fp;
+}
+
+uint64_t MinerCache::db_fingerprint(const HandleSeq& db)
+{
+	for (auto it = _fingerprints.begin(); it != _fingerprints.end(); ++it) {
+		if (it->first == db) {
+			_fingerprints.splice(_fingerprints.begin(), _fingerprints, it);
+			return it->second;
+		}
+	}
+	_fingerprints.emplace_front(db, fingerprint(db));
+	if (max_fingerprints < _fingerprints.size())
+		_fingerprints.pop_back();
+	return _fingerprints.front().second;
+}
+
+uint64_t MinerCache::pattern_check(const Handle& pattern)
+{
+	// Encode atom with variables anonymous, or numbered after var_ids
+	std::unordered_map<Handle, unsigned> var_ids;
+	std::function<void(const Handle&, bool, std::ostream&)> encode =
+		[&](const Handle& h, bool anonymous, std::ostream& os) {
+		Type t = h->get_type();
+		os << "(" << nameserver().getTypeName(t);
+		if (h->is_node()) {
+			if (t != VARIABLE_NODE)
+				os << " " << h->get_name().size() << ":" << h->get_name();
+			else if (not anonymous)
+				os << " " << var_ids.emplace(h, var_ids.size()).first->second;
+			os << ")";
+			return;
+		}
+		HandleSeq children = h->getOutgoingSet();
+		if (nameserver().isA(t, UNORDERED_LINK)) {
+			std::vector<std::pair<std::string, Handle>> sorted;
+			for (const Handle& child : children) {
+				std::stringstream ss;
+				encode(child, true, ss);
+				sorted.emplace_back(ss.str(), child);
+			}
+			std::stable_sort(sorted.begin(), sorted.end(),
+			                 [](const auto& l, const auto& r) {
+				                 return l.first < r.first; });
+			for (unsigned i = 0; i < children.size(); i++)
+				children[i] = sorted[i].second;
+		}
+		for (const Handle& child : children)
+			encode(child, anonymous, os);
+		os << ")";
+	};
+	std::stringstream ss;
+	encode(pattern->get_type() == LAMBDA_LINK ?
+	       MinerUtils::get_body(pattern) : pattern, false, ss);
+
+	// FNV-1a over the encoding
+	uint64_t check = 14695981039346656037ULL;
+	for (char c : ss.str()) {
+		check ^= (unsigned char)c;
+		check *= 1099511628211ULL;
+	}
+	return check;
+}
+
+bool MinerCache::get_support(const Handle& pattern, const HandleSeq& db,
+                             unsigned ms, double& support)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	const Entry* entry = find(pattern, db, SUPPORT);
+	// A support below the minimum support it has been calculated
+	// with is exact, otherwise it is only known to reach it.
+	if (entry and (entry->first < entry->second or ms <= entry->second)) {
+		support = entry->first;
+		return true;
+	}
+	return false;
+}
+
+bool MinerCache::set_support(const Handle& pattern, const HandleSeq& db,
+                             unsigned ms, double support)
+{
+	return insert(pattern, db, SUPPORT, {support, (double)ms});
+}
+
+TruthValuePtr MinerCache::get_emp_tv(const Handle& pattern,
+                                     const HandleSeq& db)
+{
+	return get_tv(pattern, db, EMP_TV);
+}
+
+bool MinerCache::set_emp_tv(const Handle& pattern, const HandleSeq& db,
+                            const TruthValuePtr& etv)
+{
+	return set_tv(pattern, db, EMP_TV, etv);
+}
+
+TruthValuePtr MinerCache::get_ji_tv_est(const Handle& pattern,
+                                        const HandleSeq& db)
+{
+	return get_tv(pattern, db, JI_TV_EST);
+}
+
+bool MinerCache::set_ji_tv_est(const Handle& pattern, const HandleSeq& db,
+                               const TruthValuePtr& jte)
+{
+	return set_tv(pattern, db, JI_TV_EST, jte);
+}
+
+const MinerCache::Entry* MinerCache::find(const Handle& pattern,
+                                          const HandleSeq& db, Kind kind)
+{
+	if (not _open)
+		return nullptr;
+	auto it = _entries.find({db_fingerprint(db), pattern->get_hash(), kind});
+	if (it == _entries.end() or it->second.check != pattern_check(pattern)) {
+		_misses++;
+		return nullptr;
+	}
+	_hits++;
+	_recency.splice(_recency.begin(), _recency, it->second.recency);
+	return &it->second.entry;
+}
+
+bool MinerCache::insert(const Handle& pattern, const HandleSeq& db,
+                        Kind kind, const Entry& entry)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (not _open)
+		return false;
+	insert({db_fingerprint(db), pattern->get_hash(), kind},
+	       pattern_check(pattern), entry);
+	return true;
+}
+
+void MinerCache::insert(const Key& key, uint64_t check, const Entry& entry)
+{
+	// An entry of another pattern of the same hash is replaced
+	auto it = _entries.find(key);
+	if (it != _entries.end()) {
+		it->second.entry = entry;
+		it->second.check = check;
+		_recency.splice(_recency.begin(), _recency, it->second.recency);
+		return;
+	}
+	_recency.push_front(key);
+	_entries[key] = {entry, check, _recency.begin()};
+
+	// Evict the least recently used entries beyond the capacity
+	while (0 < _capacity and _capacity < _entries.size() * entry_bytes) {
+		_entries.erase(_recency.back());
+		_recency.pop_back();
+		_evictions++;
+	}
+}
+
+TruthValuePtr MinerCache::get_tv(const Handle& pattern, const HandleSeq& db,
+                                 Kind kind)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	const Entry* entry = find(pattern, db, kind);
+	return entry ? createSimpleTruthValue(entry->first, entry->second) : nullptr;
+}
+
+bool MinerCache::set_tv(const Handle& pattern, const HandleSeq& db, Kind kind,
+                        const TruthValuePtr& tv)
+{
+	return insert(pattern, db, kind, {tv->get_mean(), tv->get_confidence()});
+}
+
+void MinerCache::load(const std::string& filename)
+{
+	_entries.clear();
+	_recency.clear();
+	std::ifstream in(filename, std::ios::binary);
+	if (not in)
+		return;
+
+	auto get = [&](auto& field) {
+		in.read(reinterpret_cast<char*>(&field), sizeof(field)); };
+	char magic[sizeof(cache_magic) - 1];
+	uint32_t version = 0;
+	uint64_t n_entries = 0;
+	in.read(magic, sizeof(magic));
+	get(version);
+	get(n_entries);
+	if (not in or std::memcmp(magic, cache_magic, sizeof(magic)) != 0
+	    or version != cache_version)
+		throw RuntimeException(TRACE_INFO, "%s is not a miner cache",
+		                       filename.c_str());
+
+	// The number of entries must match the size of the file before
+	// allocating them
+	std::streamoff header_end = in.tellg();
+	in.seekg(0, std::ios::end);
+	std::streamoff file_end = in.tellg();
+	in.seekg(header_end);
+	if (not in or (uint64_t)(file_end - header_end) / cache_entry_size < n_entries)
+		throw RuntimeException(TRACE_INFO, "Ill-formed miner cache %s",
+		                       filename.c_str());
+
+	// Entries are saved from the most to the least recently used,
+	// thus inserted in reverse order.
+	struct FileEntry
+	{
+		Key key;
+		uint64_t check;
+		Entry entry;
+	};
+	std::vector<FileEntry> entries(n_entries);
+	for (FileEntry& fe : entries) {
+		uint8_t kind;
+		get(fe.key.db);
+		get(fe.key.pattern);
+		get(kind);
+		get(fe.check);
+		get(fe.entry.first);
+		get(fe.entry.second);
+		if (not in or JI_TV_EST < kind)
+			throw RuntimeException(TRACE_INFO, "Ill-formed miner cache %s",
+			                       filename.c_str());
+		fe.key.kind = (Kind)kind;
+	}
+	for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+		insert(it->key, it->check, it->entry);
+}
+
+void MinerCache::write() const
+{
+	std::string tmp_filename = _filename + ".tmp";
+	{
+		std::ofstream out(tmp_filename, std::ios::binary);
+		auto put = [&](const auto& field) {
+			out.write(reinterpret_cast<const char*>(&field), sizeof(field)); };
+		out.write(cache_magic, sizeof(cache_magic) - 1);
+		put(cache_version);
+		put((uint64_t)_entries.size());
+		for (const Key& key : _recency) {
+			const Node& node = _entries.at(key);
+			put(key.db);
+			put(key.pattern);
+			put((uint8_t)key.kind);
+			put(node.check);
+			put(node.entry.first);
+			put(node.entry.second);
+		}
+		if (not out)
+			throw RuntimeException(TRACE_INFO, "Cannot write miner cache %s",
+			                       tmp_filename.c_str());
+	}
+	if (std::rename(tmp_filename.c_str(), _filename.c_str()) != 0)
+		throw RuntimeException(TRACE_INFO, "Cannot write miner cache %s",
+		                       _filename.c_str());
+}
+
+MinerCache& miner_cache()
+{
+	static MinerCache instance;
+	return instance;
+}
+
+} // namespace opencog
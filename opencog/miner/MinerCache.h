@@ -0,0 +1,310 @@
+/*
+ * MinerCache.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OPENCOG_MINER_CACHE_H_
+#define OPENCOG_MINER_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+
+namespace opencog
+{
+
+/**
+ * Memoization store of the supports, empirical truth values and joint
+ * independent truth value estimates of patterns, optionally bounded
+ * in memory and persistent, so that repeated analyses over the same
+ * db do not recompute them once the pattern atoms are gone.
+ *
+ * Entries are keyed by the hash of the pattern, alpha-equivalent
+ * patterns sharing the same hash, and the fingerprint of the db they
+ * have been calculated over, see fingerprint, so that values
+ * calculated over a sample, a delta, a window or a shard of a db are
+ * never returned for another db. The fingerprints of the last dbs
+ * looked up are memoized, as long as they keep the same data trees.
+ * The cache is opened loading the entries of its file, if any. While
+ * open, MinerUtils::support_mem, Surprisingness::set_emp_tv and
+ * Surprisingness::set_ji_tv_est memoize in the cache instead of
+ * attaching values to the pattern atoms (see MinerUtils::support_key,
+ * Surprisingness::emp_tv_key and Surprisingness::ji_tv_est_key),
+ * which would keep every candidate pattern ever considered in the
+ * atomspace with its values, and the cache is consulted before any
+ * pattern matching. When the memory of the entries exceeds the
+ * capacity of the cache, the least recently used entries are
+ * evicted. The entries are saved back to the file when the cache is
+ * closed.
+ *
+ * As distinct patterns may share the same hash, each entry also
+ * records a check of the pattern, a hash of an encoding of it
+ * independent of the names of its variables, see pattern_check, and
+ * an entry whose check differs from the one of the pattern looked up
+ * is a miss.
+ *
+ * The file is a binary file, in the byte order of the host, made of
+ * the magic string "MINCACHE", the format version and the number of
+ * entries, on 4 and 8 bytes, followed by the entries, from the most to
+ * the least recently used
+ *
+ * <DB FINGERPRINT> <PATTERN HASH> <KIND> <PATTERN CHECK> <FIRST> <SECOND>
+ *
+ * on 8, 8, 1, 8, 8 and 8 bytes, where KIND is the kind of the entry, and
+ * FIRST and SECOND are doubles, the support and the minimum support
+ * it has been calculated with for a support, the mean and the
+ * confidence for a truth value.
+ */
+class MinerCache
+{
+public:
+	/**
+	 * CTor, closed cache.
+	 */
+	MinerCache();
+
+	/**
+	 * Statistics of the cache since it has been opened.
+	 */
+	struct Statistics
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		size_t entries;
+		size_t bytes;
+
+		/**
+		 * Return the ratio of lookups that were hits, 0 if none.
+		 */
+		double hit_rate() const;
+	};
+
+	/**
+	 * Open the cache, after closing it if already open, priming the
+	 * fingerprint of db, loading the entries of the given file if it
+	 * exists, or in memory only if filename is empty. capacity is the
+	 * maximum memory of the entries in bytes, 0 for no maximum. Throw a
+	 * RuntimeException if the file cannot be read or is ill-formed.
+	 */
+	void open(const std::string& filename, const HandleSeq& db,
+	          size_t capacity=0);
+
+	/**
+	 * Save the entries to the file the cache was opened with, if any,
+	 * and close it, dropping its entries. Throw a RuntimeException on
+	 * failure.
+	 */
+	void close();
+
+	/**
+	 * Return true iff the cache is open.
+	 */
+	bool is_open() const;
+
+	/**
+	 * Write all entries to the file the cache was opened with, first
+	 * to a temporary file then renamed, like MinerCheckpoint::save.
+	 * Throw a RuntimeException on failure.
+	 */
+	void save() const;
+
+	/**
+	 * Return the number of entries, over all dbs.
+	 */
+	size_t size() const;
+
+	/**
+	 * Return the statistics of the cache since it has been opened.
+	 */
+	Statistics statistics() const;
+
+	/**
+	 * Return the fingerprint of a db, independent of the order of its
+	 * data trees.
+	 */
+	static uint64_t fingerprint(const HandleSeq& db);
+
+	/**
+	 * If the cache is open and holds the support of pattern over db,
+	 * usable with minimum support ms, that is either exact or
+	 * reaching ms, see MinerUtils::support, then set support to it
+	 * and return true. Otherwise return false.
+	 */
+	bool get_support(const Handle& pattern, const HandleSeq& db,
+	                 unsigned ms, double& support);
+
+	/**
+	 * Record the support of pattern over db calculated with minimum
+	 * support ms, if the cache is open. Return false iff the cache is
+	 * closed.
+	 */
+	bool set_support(const Handle& pattern, const HandleSeq& db,
+	                 unsigned ms, double support);
+
+	/**
+	 * Return the empirical truth value of pattern over db, or nullptr
+	 * if the cache is closed or does not hold it.
+	 */
+	TruthValuePtr get_emp_tv(const Handle& pattern, const HandleSeq& db);
+
+	/**
+	 * Record the empirical truth value of pattern over db, if the
+	 * cache is open. Return false iff the cache is closed.
+	 */
+	bool set_emp_tv(const Handle& pattern, const HandleSeq& db,
+	                const TruthValuePtr& etv);
+
+	/**
+	 * Like get_emp_tv for the joint independent truth value
+	 * estimate.
+	 */
+	TruthValuePtr get_ji_tv_est(const Handle& pattern, const HandleSeq& db);
+
+	/**
+	 * Like set_emp_tv for the joint independent truth value
+	 * estimate.
+	 */
+	bool set_ji_tv_est(const Handle& pattern, const HandleSeq& db,
+	                   const TruthValuePtr& jte);
+
+private:
+	enum Kind : uint8_t { SUPPORT, EMP_TV, JI_TV_EST };
+
+	struct Key
+	{
+		uint64_t db;
+		uint64_t pattern;
+		Kind kind;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+	using Entry = std::pair<double, double>;
+
+	// Entry with the check of its pattern and its position in the
+	// recency list
+	struct Node
+	{
+		Entry entry;
+		uint64_t check;
+		std::list<Key>::iterator recency;
+	};
+
+	// Approximate memory of an entry, including the overhead of the
+	// containers
+	static const size_t entry_bytes;
+
+	/**
+	 * Return the fingerprint of db, memoized for the last few dbs.
+	 * The mutex must be locked.
+	 */
+	uint64_t db_fingerprint(const HandleSeq& db);
+
+	/**
+	 * Return the check of pattern, FNV-1a of an encoding of it where
+	 * variables are numbered by order of first occurrence in its
+	 * body, the children of unordered links being visited in the
+	 * order of their encodings with anonymous variables, so that
+	 * alpha-equivalent patterns get the same check, except possibly
+	 * when such children tie, which only causes misses.
+	 */
+	static uint64_t pattern_check(const Handle& pattern);
+
+	/**
+	 * Return the entry of pattern of the given kind over db, marked
+	 * as most recently used, or nullptr if the cache is closed or
+	 * does not hold it, updating the statistics. The mutex must be
+	 * locked.
+	 */
+	const Entry* find(const Handle& pattern, const HandleSeq& db, Kind kind);
+
+	/**
+	 * Record the entry of pattern of the given kind over db, if the
+	 * cache is open, evicting the least recently used entries beyond
+	 * the capacity. Return false iff the cache is closed.
+	 */
+	bool insert(const Handle& pattern, const HandleSeq& db, Kind kind,
+	            const Entry& entry);
+
+	/**
+	 * Record an entry as most recently used, then evict the least
+	 * recently used entries beyond the capacity. The mutex must be
+	 * locked.
+	 */
+	void insert(const Key& key, uint64_t check, const Entry& entry);
+
+	/**
+	 * Like get_emp_tv and set_emp_tv for the given kind.
+	 */
+	TruthValuePtr get_tv(const Handle& pattern, const HandleSeq& db,
+	                     Kind kind);
+	bool set_tv(const Handle& pattern, const HandleSeq& db, Kind kind,
+	            const TruthValuePtr& tv);
+
+	/**
+	 * Respectively read the entries of the given file, if it exists,
+	 * and write them to _filename. The mutex must be locked.
+	 */
+	void load(const std::string& filename);
+	void write() const;
+
+	// Whether the cache is open, the file it has been opened with,
+	// empty if in memory only, and its capacity in bytes, 0 for no
+	// maximum
+	bool _open;
+	std::string _filename;
+	size_t _capacity;
+
+	// Last dbs looked up, with their fingerprints, from the most to
+	// the least recently used
+	std::list<std::pair<HandleSeq, uint64_t>> _fingerprints;
+	static const size_t max_fingerprints;
+
+	// Entries, and their keys from the most to the least recently
+	// used
+	std::unordered_map<Key, Node, KeyHash> _entries;
+	std::list<Key> _recency;
+
+	// Lookup statistics since the cache has been opened
+	uint64_t _hits;
+	uint64_t _misses;
+	uint64_t _evictions;
+
+	// Mining and surprisingness may run in several threads
+	mutable std::mutex _mutex;
+};
+
+// singleton instance (following Meyer's design pattern)
+MinerCache& miner_cache();
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_CACHE_H_ */
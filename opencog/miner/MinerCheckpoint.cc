@@ -0,0 +1,196 @@
+/*
+ * MinerCheckpoint.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "MinerCheckpoint.h"
+
+#include <opencog/util/exceptions.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace opencog
+{
+
+MinerCheckpoint::MinerCheckpoint() {}
+
+unsigned MinerCheckpoint::add(const Handle& pattern, unsigned support,
+                              unsigned parent)
+{
+	completed.push_back(false);
+	return patterns.add(pattern, support, parent);
+}
+
+bool MinerCheckpoint::empty() const
+{
+	return patterns.empty();
+}
+
+void MinerCheckpoint::clear()
+{
+	parameters.clear();
+	patterns = PatternForest();
+	completed.clear();
+}
+
+void MinerCheckpoint::save(const std::string& filename) const
+{
+	std::string tmp_filename = filename + ".tmp";
+	{
+		std::ofstream out(tmp_filename);
+		out << "miner-checkpoint 1" << std::endl;
+		for (const auto& param : parameters)
+			out << "parameter " << param.first << " " << param.second << std::endl;
+		for (unsigned i = 0; i < patterns.size(); i++)
+			out << "pattern " << (int)patterns.parent(i) << " "
+			    << patterns.support(i) << " " << completed[i] << " "
+			    << encode_atom(patterns.pattern(i)) << std::endl;
+		if (not out)
+			throw RuntimeException(TRACE_INFO, "Cannot write checkpoint %s",
+			                       tmp_filename.c_str());
+	}
+	if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+		throw RuntimeException(TRACE_INFO, "Cannot write checkpoint %s",
+		                       filename.c_str());
+}
+
+void MinerCheckpoint::load(const std::string& filename)
+{
+	std::ifstream in(filename);
+	std::string line;
+	if (not std::getline(in, line) or line != "miner-checkpoint 1")
+		throw RuntimeException(TRACE_INFO, "%s is not a miner checkpoint",
+		                       filename.c_str());
+
+	clear();
+	while (std::getline(in, line)) {
+		std::istringstream ls(line);
+		std::string kind;
+		ls >> kind;
+		if (kind == "parameter") {
+			std::string name, value;
+			ls >> name;
+			std::getline(ls >> std::ws, value);
+			parameters[name] = value;
+		} else if (kind == "pattern") {
+			int parent;
+			unsigned support;
+			bool cmpl;
+			if (not (ls >> parent >> support >> cmpl)
+			    or parent >= (int)patterns.size())
+				throw RuntimeException(TRACE_INFO, "Ill-formed checkpoint line: %s",
+				                       line.c_str());
+			size_t pos = ls.tellg();
+			Handle pattern = decode_atom(line, pos);
+			unsigned i = add(pattern, support,
+			                 parent < 0 ? PatternForest::npos : parent);
+			completed[i] = cmpl;
+		} else if (not kind.empty()) {
+			throw RuntimeException(TRACE_INFO, "Ill-formed checkpoint line: %s",
+			                       line.c_str());
+		}
+	}
+}
+
+bool MinerCheckpoint::exists(const std::string& filename)
+{
+	return std::ifstream(filename).good();
+}
+
+std::string MinerCheckpoint::encode_atom(const Handle& h)
+{
+	std::stringstream ss;
+	ss << "(" << nameserver().getTypeName(h->get_type());
+	if (h->is_node()) {
+		ss << " \"";
+		for (char c : h->get_name()) {
+			if (c == '\\' or c == '"')
+				ss << '\\' << c;
+			else if (c == '\n')
+				ss << "\\n";
+			else
+				ss << c;
+		}
+		ss << "\"";
+	} else {
+		for (const Handle& child : h->getOutgoingSet())
+			ss << " " << encode_atom(child);
+	}
+	ss << ")";
+	return ss.str();
+}
+
+Handle MinerCheckpoint::decode_atom(const std::string& str, size_t& pos)
+{
+	auto ill_formed = [&]() {
+		return RuntimeException(TRACE_INFO, "Ill-formed atom at %zu in %s",
+		                        pos, str.c_str());
+	};
+	auto skip_spaces = [&]() {
+		while (pos < str.size() and isspace(str[pos]))
+			pos++;
+	};
+
+	skip_spaces();
+	if (pos >= str.size() or str[pos] != '(')
+		throw ill_formed();
+	size_t type_start = ++pos;
+	while (pos < str.size() and not isspace(str[pos]) and str[pos] != ')')
+		pos++;
+	Type type = nameserver().getType(str.substr(type_start, pos - type_start));
+	if (type == NOTYPE)
+		throw ill_formed();
+	skip_spaces();
+
+	Handle h;
+	if (nameserver().isNode(type)) {
+		if (pos >= str.size() or str[pos] != '"')
+			throw ill_formed();
+		std::string name;
+		for (pos++; pos < str.size() and str[pos] != '"'; pos++) {
+			if (str[pos] == '\\' and pos + 1 < str.size())
+				name += str[++pos] == 'n' ? '\n' : str[pos];
+			else
+				name += str[pos];
+		}
+		if (pos++ >= str.size())
+			throw ill_formed();
+		h = createNode(type, std::move(name));
+	} else {
+		HandleSeq outgoing;
+		while (pos < str.size() and str[pos] != ')') {
+			outgoing.push_back(decode_atom(str, pos));
+			skip_spaces();
+		}
+		h = createLink(std::move(outgoing), type);
+	}
+
+	skip_spaces();
+	if (pos >= str.size() or str[pos] != ')')
+		throw ill_formed();
+	pos++;
+	return h;
+}
+
+} // namespace opencog
@@ -0,0 +1,128 @@
+/*
+ * MinerCheckpoint.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENCOG_MINER_CHECKPOINT_H_
+#define OPENCOG_MINER_CHECKPOINT_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <opencog/atoms/base/Handle.h>
+
+#include "PatternForest.h"
+
+namespace opencog
+{
+
+/**
+ * State of a mining run, that is its parameters, the patterns found
+ * so far with their supports, and whether all specializations of
+ * each pattern have been found (in which case the search does not
+ * need to go through them again), so that it can be saved to a file
+ * and resumed later, if the run gets interrupted.
+ *
+ * The file is a text file with a header line followed by one line per
+ * parameter and per pattern, the latter in the order of the forest,
+ * so that parents precede their children
+ *
+ * miner-checkpoint 1
+ * parameter <NAME> <VALUE>
+ * pattern <PARENT> <SUPPORT> <COMPLETED> <ATOMESE>
+ *
+ * where PARENT is the index of the parent pattern, -1 for roots, and
+ * ATOMESE is the pattern written as an s-expression, see
+ * encode_atom.
+ */
+struct MinerCheckpoint
+{
+	/**
+	 * CTor, empty checkpoint.
+	 */
+	MinerCheckpoint();
+
+	/**
+	 * Add a pattern with its support as last child of parent (npos
+	 * for a root), not completed yet. Return its index.
+	 */
+	unsigned add(const Handle& pattern, unsigned support,
+	             unsigned parent=PatternForest::npos);
+
+	/**
+	 * Return true iff no pattern has been added.
+	 */
+	bool empty() const;
+
+	/**
+	 * Remove all parameters and patterns.
+	 */
+	void clear();
+
+	/**
+	 * Write the checkpoint to the given file, first to a temporary
+	 * file then renamed, so that an interruption while saving never
+	 * leaves a partial checkpoint behind. Throw a RuntimeException
+	 * on failure.
+	 */
+	void save(const std::string& filename) const;
+
+	/**
+	 * Read the checkpoint from the given file, replacing the current
+	 * content. Throw a RuntimeException if the file cannot be read or
+	 * is ill-formed.
+	 */
+	void load(const std::string& filename);
+
+	/**
+	 * Return true iff the given file exists and can be read.
+	 */
+	static bool exists(const std::string& filename);
+
+	/**
+	 * Write an atom as an s-expression, like
+	 *
+	 * (LambdaLink (VariableNode "$X") (InheritanceLink (VariableNode "$X") (ConceptNode "A")))
+	 *
+	 * with backslashes, quotes and new lines of node names escaped.
+	 */
+	static std::string encode_atom(const Handle& h);
+
+	/**
+	 * Read an atom written by encode_atom, starting at pos, which is
+	 * moved after it. The atom is not added to any atomspace. Throw a
+	 * RuntimeException if ill-formed.
+	 */
+	static Handle decode_atom(const std::string& str, size_t& pos);
+
+	// Parameters of the run, by name, stored as strings, the values
+	// must not contain new lines.
+	std::map<std::string, std::string> parameters;
+
+	// Patterns found so far, with their supports
+	PatternForest patterns;
+
+	// Whether all specializations of each pattern have been found
+	std::vector<bool> completed;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_CHECKPOINT_H_ */
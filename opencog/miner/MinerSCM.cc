@@ -28,10 +28,14 @@
 #include <opencog/util/Logger.h>
 #include <opencog/guile/SchemeModule.h>
 #include <opencog/atoms/core/NumberNode.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
 
 #include "MinerUtils.h"
 #include "Surprisingness.h"
 #include "MinerLogger.h"
+#include "MinerCache.h"
+#include "DbSnapshot.h"
+#include "MinerWorkers.h"
 
 namespace opencog {
 
@@ -93,6 +97,120 @@ protected:
 	 */
 	bool do_enough_support(Handle pattern, Handle db, Handle ms);
 
+	/**
+	 * Given a pattern and a db concept, return true iff the pattern
+	 * is closed, that is no shallow specialization of it has the same
+	 * support, see MinerUtils::is_closed.
+	 */
+	bool do_closed(Handle pattern, Handle db);
+
+	/**
+	 * Given a pattern, a db concept and a minimum support, return
+	 * true iff the pattern is maximal, that is no shallow
+	 * specialization of it has enough support, see
+	 * MinerUtils::is_maximal.
+	 */
+	bool do_maximal(Handle pattern, Handle db, Handle ms);
+
+	/**
+	 * Given a pattern and a db concept, return the support of the
+	 * pattern as a number node.
+	 */
+	Handle do_support(Handle pattern, Handle db);
+
+	/**
+	 * Like do_support, but over the weighted db of the db concept,
+	 * where each member counts as its multiplicity, see
+	 * MinerUtils::get_weighted_db.
+	 */
+	Handle do_weighted_support(Handle pattern, Handle db);
+
+	/**
+	 * Set/get the multiplicity of a data tree in a db, given the
+	 * member link between them, see MinerUtils::set_multiplicity.
+	 */
+	void do_set_multiplicity(Handle member, Handle multiplicity);
+	double do_multiplicity(Handle member);
+
+	/**
+	 * Run the C++ Miner over db in top-k mode, starting from initpat
+	 * with minimum support ms, and return the effective minimum
+	 * support reached, that is the support of the k-th most frequent
+	 * pattern found, as a number node, see MinerParameters::top_k.
+	 *
+	 * options is a list of the restrictions of the search, in the
+	 * format of do_mine_cpp, among maximum-conjuncts,
+	 * maximum-variables, maximum-cnjexp-variables,
+	 * maximum-spcial-conjuncts and enforce-specialization.
+	 */
+	Handle do_top_k_minsup(Handle db, Handle k, Handle ms, Handle initpat,
+	                       Handle options);
+
+	/**
+	 * Return the resident memory of the process in bytes, see
+	 * MinerUtils::resident_memory.
+	 */
+	double do_resident_memory();
+
+	/**
+	 * Save a checkpoint of a cog-mine run to the given file (a
+	 * concept node named after it), with the patterns found so far
+	 * (in a set link), their supports w.r.t. db and ms, and the
+	 * options of the run (a concept node named after their Scheme
+	 * representation), see MinerCheckpoint.
+	 */
+	void do_save_checkpoint(Handle filename, Handle patterns, Handle db,
+	                        Handle ms, Handle options);
+
+	/**
+	 * Load the checkpoint saved by do_save_checkpoint from the given
+	 * file and return its patterns in a set link, with their supports
+	 * memoized.
+	 */
+	Handle do_load_checkpoint(Handle filename);
+
+	/**
+	 * Return the options of the checkpoint saved by
+	 * do_save_checkpoint in the given file. Throw a RuntimeException
+	 * if it has been saved over another db.
+	 */
+	std::string do_checkpoint_options(Handle filename, Handle db);
+
+	/**
+	 * Save the members of a db concept to the given file (a concept
+	 * node named after it) as a db snapshot, see DbSnapshot.
+	 */
+	void do_save_db(Handle filename, Handle db);
+
+	/**
+	 * Load the db snapshot of the given file (a concept node named
+	 * after it) as members of the given db concept, which is
+	 * returned.
+	 */
+	Handle do_load_db(Handle filename, Handle db);
+
+	/**
+	 * Open the cache of supports and truth values for db from the
+	 * given file (a concept node named after it, with an empty name
+	 * for a cache in memory only), loading it if it exists, with the
+	 * given capacity in bytes (a number node, non-positive for no
+	 * maximum), see MinerCache.
+	 */
+	void do_open_cache(Handle filename, Handle db, Handle capacity);
+
+	/**
+	 * Save the cache to its file, if any, and close it.
+	 */
+	void do_close_cache();
+
+	/**
+	 * Return the statistics of the cache as a list link of number
+	 * nodes, the numbers of hits, misses, evictions and entries, the
+	 * memory of the entries in bytes, and the hit rate, see
+	 * MinerCache::Statistics.
+	 */
+	Handle do_cache_statistics();
+
 	/**
 	 * Construct the conjunction of 2 patterns. If cnjtion is a
 	 * conjunction, then expand it with pattern. It is assumed that
@@ -119,6 +237,33 @@ protected:
 	double do_isurp(Handle pattern, Handle db, Handle db_ratio);
 	double do_nisurp(Handle pattern, Handle db, Handle db_ratio);
 
+	/**
+	 * Given a set of patterns, return the k most I-Surprising ones,
+	 * sorted by decreasing surprisingness, as a list of
+	 *
+	 * Evaluation (stv surp 1)
+	 *   Predicate "isurp"
+	 *   List
+	 *     pattern
+	 *     db
+	 *
+	 * like produced by the I-Surprisingness rules. Only patterns
+	 * that may enter the top k have their empirical probability
+	 * calculated (see Surprisingness::isurp_top_k).
+	 *
+	 * do_isurp_top_k: I-Surprisingness
+	 * do_nisurp_top_k: normalized I-Surprisingness
+	 */
+	Handle do_isurp_top_k(Handle patterns, Handle db, Handle k, Handle db_ratio);
+	Handle do_nisurp_top_k(Handle patterns, Handle db, Handle k, Handle db_ratio);
+
+	/**
+	 * Like do_isurp_top_k but for any surprisingness mode of cog-mine
+	 * (a concept node named after it), see Surprisingness::surp_top_k.
+	 */
+	Handle do_surp_top_k(Handle mode, Handle patterns, Handle db, Handle k,
+	                     Handle db_ratio);
+
 	/**
 	 * Calculate the empirical truth value of pattern
 	 */
@@ -134,11 +279,134 @@ protected:
 	 */
 	double do_jsd(TruthValuePtr ltv, TruthValuePtr rtv);
 
+	/**
+	 * Set the number of bins used to discretize the cdfs in
+	 * cog-jsd.
+	 */
+	void do_set_jsd_bins(Handle bins);
+
+	/**
+	 * Run the C++ Miner over db with minimum support ms, starting
+	 * from initpat, down to maxdepth specializations (negative for
+	 * unlimited), and return the resulting pattern lattice, see
+	 * PatternLattice::to_atomese.
+	 */
+	Handle do_mine_lattice(Handle db, Handle ms, Handle initpat,
+	                       Handle maxdepth);
+
+	/**
+	 * Run the C++ Miner over db with minimum support ms, starting
+	 * from initpat, and return the mined patterns in a set link, with
+	 * their supports and their parents in the search memoized, see
+	 * MinerUtils::set_parent. That is the native counterpart of the
+	 * rule engine run by cog-mine, see cog-mine-native.
+	 *
+	 * options is a list of pairs (lists) of an option name (a concept
+	 * node) and its value, a number node unless otherwise specified,
+	 * among
+	 *
+	 * maximum-conjuncts: non-positive for unlimited
+	 * maximum-variables
+	 * maximum-cnjexp-variables
+	 * maximum-spcial-conjuncts
+	 * enforce-specialization: 0 or 1
+	 * output-mode: concept node all, closed or maximal
+	 * top-k: non-positive for disabled
+	 * time-budget: non-positive for no budget
+	 * memory-budget: non-positive for no budget
+	 * checkpoint: concept node named after the checkpoint file
+	 * checkpoint-interval
+	 * jobs: number of threads counting supports
+	 * valuations-chunk-size: if positive, number of data trees
+	 *                        per chunk valuations are streamed by,
+	 *                        cannot be combined with jobs above 1
+	 * workers: number of worker processes, each mining the
+	 *          specializations of some of the shallow
+	 *          specializations of initpat, see MinerWorkers, 0 (the
+	 *          default) for mining in this process only. Workers are
+	 *          forked from the Guile process, which is unsafe if
+	 *          other threads, such as other Guile threads or a
+	 *          cogserver, may access the atomspace meanwhile. Cannot
+	 *          be combined with sample-size
+	 * sample-size: if positive, size of the random sample of db to
+	 *              mine first, see Miner::mine_sample
+	 * sample-lowering: factor lowering the minimum support over the
+	 *                  sample, 0.8 by default
+	 * warm-start: set link of patterns previously mined with a
+	 *             greater minimum support, with their supports and
+	 *             parents memoized, as returned by cog-mine-cpp.
+	 *             Cannot be combined with workers nor sample-size
+	 * snapshot: concept node named after a db snapshot file, to mine
+	 *           instead of the members of db, without adding its data
+	 *           trees to the atomspace, see DbSnapshot. If
+	 *           valuations-chunk-size is positive, and neither
+	 *           conjunction expansion, checkpoint, workers,
+	 *           sample-size nor warm-start is used, its data trees
+	 *           are streamed chunk by chunk rather than all held in
+	 *           memory, see Miner::mine_forest(const DbView&)
+	 *
+	 * If members of db have multiplicities, see cog-set-multiplicity!,
+	 * the weighted db is mined, see Miner::mine_forest(const
+	 * HandleUCounter&), which cannot be combined with workers,
+	 * sample-size nor warm-start.
+	 *
+	 * see MinerParameters and Miner::mine_warm_start. Missing options
+	 * keep their default values.
+	 */
+	Handle do_mine_cpp(Handle db, Handle ms, Handle initpat, Handle options);
+
+	/**
+	 * Given patterns previously mined over a db concept with minimum
+	 * support ms from initpat (in a set link, with their supports
+	 * memoized, as returned by cog-mine-cpp), and the data trees
+	 * added since to db (in a set or list link), return the updated
+	 * patterns in a set link, with their updated supports and their
+	 * parents memoized, including the newly frequent ones, see
+	 * Miner::mine_incremental.
+	 */
+	Handle do_mine_incremental(Handle patterns, Handle db, Handle delta,
+	                           Handle ms, Handle initpat);
+
 	/**
 	 * Return the Miner logger
 	 */
 	Logger* do_miner_logger();
 
+private:
+	/**
+	 * If name is a restriction of the search, see do_top_k_minsup,
+	 * set it in param to number and return true, otherwise return
+	 * false.
+	 */
+	static bool set_restriction(MinerParameters& param,
+	                            const std::string& name, double number);
+
+	/**
+	 * Add the patterns of forest to as with their supports and their
+	 * parents memoized, see MinerUtils::set_parent, and return them
+	 * in a set link.
+	 */
+	static Handle forest_to_atomese(const PatternForest& forest,
+	                                AtomSpace& as);
+
+	/**
+	 * Given a set link of patterns, as returned by forest_to_atomese,
+	 * return their forest, with their supports given by support, so
+	 * that the depths of the patterns are those of the search they
+	 * have been mined by. A pattern whose memoized parent is not in
+	 * patterns, or without memoized parent, is a root.
+	 */
+	static PatternForest atomese_to_forest(
+		const Handle& patterns,
+		const std::function<unsigned(const Handle&)>& support);
+
+	/**
+	 * Helper for do_isurp_top_k, do_nisurp_top_k and do_surp_top_k,
+	 * prim being the name of the calling primitive.
+	 */
+	Handle surp_top_k(const std::string& prim, const std::string& mode,
+	                  Handle patterns, Handle db, Handle k, Handle db_ratio);
+
 public:
 	MinerSCM();
 };
@@ -167,6 +435,54 @@ void MinerSCM::init(void)
 	define_scheme_primitive("cog-enough-support?",
 		&MinerSCM::do_enough_support, this, "miner");
 
+	define_scheme_primitive("cog-closed?",
+		&MinerSCM::do_closed, this, "miner");
+
+	define_scheme_primitive("cog-maximal?",
+		&MinerSCM::do_maximal, this, "miner");
+
+	define_scheme_primitive("cog-support",
+		&MinerSCM::do_support, this, "miner");
+
+	define_scheme_primitive("cog-weighted-support",
+		&MinerSCM::do_weighted_support, this, "miner");
+
+	define_scheme_primitive("cog-set-multiplicity!",
+		&MinerSCM::do_set_multiplicity, this, "miner");
+
+	define_scheme_primitive("cog-multiplicity",
+		&MinerSCM::do_multiplicity, this, "miner");
+
+	define_scheme_primitive("cog-top-k-minsup",
+		&MinerSCM::do_top_k_minsup, this, "miner");
+
+	define_scheme_primitive("cog-resident-memory",
+		&MinerSCM::do_resident_memory, this, "miner");
+
+	define_scheme_primitive("cog-miner-save-checkpoint",
+		&MinerSCM::do_save_checkpoint, this, "miner");
+
+	define_scheme_primitive("cog-miner-load-checkpoint",
+		&MinerSCM::do_load_checkpoint, this, "miner");
+
+	define_scheme_primitive("cog-miner-checkpoint-options",
+		&MinerSCM::do_checkpoint_options, this, "miner");
+
+	define_scheme_primitive("cog-miner-save-db",
+		&MinerSCM::do_save_db, this, "miner");
+
+	define_scheme_primitive("cog-miner-load-db",
+		&MinerSCM::do_load_db, this, "miner");
+
+	define_scheme_primitive("cog-miner-open-cache",
+		&MinerSCM::do_open_cache, this, "miner");
+
+	define_scheme_primitive("cog-miner-close-cache",
+		&MinerSCM::do_close_cache, this, "miner");
+
+	define_scheme_primitive("cog-miner-cache-statistics",
+		&MinerSCM::do_cache_statistics, this, "miner");
+
 	define_scheme_primitive("cog-expand-conjunction",
 		&MinerSCM::do_expand_conjunction, this, "miner");
 
@@ -182,6 +498,15 @@ void MinerSCM::init(void)
 	define_scheme_primitive("cog-nisurp",
 		&MinerSCM::do_nisurp, this, "miner");
 
+	define_scheme_primitive("cog-isurp-top-k",
+		&MinerSCM::do_isurp_top_k, this, "miner");
+
+	define_scheme_primitive("cog-nisurp-top-k",
+		&MinerSCM::do_nisurp_top_k, this, "miner");
+
+	define_scheme_primitive("cog-surp-top-k",
+		&MinerSCM::do_surp_top_k, this, "miner");
+
 	define_scheme_primitive("cog-emp-tv",
 		&MinerSCM::do_emp_tv, this, "miner");
 
@@ -191,6 +516,18 @@ void MinerSCM::init(void)
 	define_scheme_primitive("cog-jsd",
 		&MinerSCM::do_jsd, this, "miner");
 
+	define_scheme_primitive("cog-set-jsd-bins!",
+		&MinerSCM::do_set_jsd_bins, this, "miner");
+
+	define_scheme_primitive("cog-mine-lattice",
+		&MinerSCM::do_mine_lattice, this, "miner");
+
+	define_scheme_primitive("cog-mine-cpp",
+		&MinerSCM::do_mine_cpp, this, "miner");
+
+	define_scheme_primitive("cog-mine-incremental",
+		&MinerSCM::do_mine_incremental, this, "miner");
+
 	define_scheme_primitive("cog-miner-logger",
 		&MinerSCM::do_miner_logger, this, "miner");
 }
@@ -269,6 +606,156 @@ bool MinerSCM::do_enough_support(Handle pattern, Handle db, Handle ms_h)
 	return MinerUtils::enough_support(pattern, db_seq, ms);
 }
 
+bool MinerSCM::do_closed(Handle pattern, Handle db)
+{
+	return MinerUtils::is_closed(pattern, MinerUtils::get_db(db));
+}
+
+bool MinerSCM::do_maximal(Handle pattern, Handle db, Handle ms_h)
+{
+	return MinerUtils::is_maximal(pattern, MinerUtils::get_db(db),
+	                              MinerUtils::get_uint(ms_h));
+}
+
+Handle MinerSCM::do_support(Handle pattern, Handle db)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-support");
+	unsigned sup = MinerUtils::support(pattern, MinerUtils::get_db(db), UINT_MAX);
+	return asp->add_node(NUMBER_NODE, std::to_string(sup));
+}
+
+Handle MinerSCM::do_weighted_support(Handle pattern, Handle db)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-weighted-support");
+	unsigned sup = MinerUtils::support(pattern, MinerUtils::get_weighted_db(db),
+	                                   UINT_MAX);
+	return asp->add_node(NUMBER_NODE, std::to_string(sup));
+}
+
+void MinerSCM::do_set_multiplicity(Handle member, Handle multiplicity)
+{
+	MinerUtils::set_multiplicity(member, MinerUtils::get_uint(multiplicity));
+}
+
+double MinerSCM::do_multiplicity(Handle member)
+{
+	return MinerUtils::get_multiplicity(member);
+}
+
+Handle MinerSCM::do_top_k_minsup(Handle db, Handle k, Handle ms,
+                                 Handle initpat, Handle options)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-top-k-minsup");
+
+	// Fetch arguments
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	MinerParameters param(MinerUtils::get_uint(ms), 1, initpat);
+	param.top_k = MinerUtils::get_uint(k);
+	for (const Handle& option : options->getOutgoingSet()) {
+		const std::string& name = option->getOutgoingAtom(0)->get_name();
+		if (not set_restriction(param, name,
+		                        MinerUtils::get_double(option->getOutgoingAtom(1))))
+			throw RuntimeException(TRACE_INFO, "Unknown restriction %s",
+			                       name.c_str());
+	}
+
+	// Only the effective minimum support is needed
+	Miner miner(param);
+	miner(db_seq, [](const Handle&, unsigned, unsigned) { return true; });
+	return asp->add_node(NUMBER_NODE,
+	                     std::to_string(miner.get_effective_minsup()));
+}
+
+double MinerSCM::do_resident_memory()
+{
+	return MinerUtils::resident_memory();
+}
+
+void MinerSCM::do_save_checkpoint(Handle filename, Handle patterns,
+                                  Handle db, Handle ms_h, Handle options)
+{
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	unsigned ms = MinerUtils::get_uint(ms_h);
+
+	// Patterns found by the rule engine are its frontier, none is
+	// considered completely explored.
+	MinerCheckpoint checkpoint;
+	checkpoint.parameters["cog-mine"] = options->get_name();
+	checkpoint.parameters["db"] = std::to_string(MinerCache::fingerprint(db_seq));
+	for (const Handle& pattern : patterns->getOutgoingSet())
+		checkpoint.add(pattern, MinerUtils::support_mem(pattern, db_seq, ms));
+	checkpoint.save(filename->get_name());
+}
+
+Handle MinerSCM::do_load_checkpoint(Handle filename)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-miner-load-checkpoint");
+
+	MinerCheckpoint checkpoint;
+	checkpoint.load(filename->get_name());
+	HandleSeq patterns;
+	for (unsigned i = 0; i < checkpoint.patterns.size(); i++) {
+		Handle pattern = asp->add_atom(checkpoint.patterns.pattern(i));
+		MinerUtils::set_support(pattern, checkpoint.patterns.support(i));
+		patterns.push_back(pattern);
+	}
+	return asp->add_link(SET_LINK, std::move(patterns));
+}
+
+std::string MinerSCM::do_checkpoint_options(Handle filename, Handle db)
+{
+	MinerCheckpoint checkpoint;
+	checkpoint.load(filename->get_name());
+	uint64_t fp = MinerCache::fingerprint(MinerUtils::get_db(db));
+	if (checkpoint.parameters["db"] != std::to_string(fp))
+		throw RuntimeException(TRACE_INFO,
+		                       "Checkpoint %s has a different db",
+		                       filename->get_name().c_str());
+	return checkpoint.parameters["cog-mine"];
+}
+
+void MinerSCM::do_save_db(Handle filename, Handle db)
+{
+	DbSnapshot::save(filename->get_name(), MinerUtils::get_db(db));
+}
+
+Handle MinerSCM::do_load_db(Handle filename, Handle db)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-miner-load-db");
+
+	DbSnapshot snapshot;
+	snapshot.open(filename->get_name());
+	Handle db_cpt = asp->add_atom(db);
+	for (const Handle& dt : snapshot.get_db())
+		asp->add_link(MEMBER_LINK, asp->add_atom(dt), db_cpt);
+	return db_cpt;
+}
+
+void MinerSCM::do_open_cache(Handle filename, Handle db, Handle capacity)
+{
+	double cap = MinerUtils::get_double(capacity);
+	miner_cache().open(filename->get_name(), MinerUtils::get_db(db),
+	                   cap <= 0 ? 0 : (size_t)cap);
+}
+
+void MinerSCM::do_close_cache()
+{
+	miner_cache().close();
+}
+
+Handle MinerSCM::do_cache_statistics()
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-miner-cache-statistics");
+
+	MinerCache::Statistics stats = miner_cache().statistics();
+	HandleSeq numbers;
+	for (double number : {(double)stats.hits, (double)stats.misses,
+	                      (double)stats.evictions, (double)stats.entries,
+	                      (double)stats.bytes, stats.hit_rate()})
+		numbers.push_back(asp->add_node(NUMBER_NODE, std::to_string(number)));
+	return asp->add_link(LIST_LINK, std::move(numbers));
+}
+
 Handle MinerSCM::do_expand_conjunction(Handle cnjtion, Handle pattern,
                                        Handle db, Handle ms_h, Handle mv_h,
                                        bool es)
@@ -321,6 +808,113 @@ double MinerSCM::do_nisurp(Handle pattern, Handle db, Handle db_ratio)
 	return Surprisingness::isurp(pattern, db_seq, true, db_rat);
 }
 
+Handle MinerSCM::do_isurp_top_k(Handle patterns, Handle db,
+                                Handle k, Handle db_ratio)
+{
+	return surp_top_k("cog-isurp-top-k", "isurp", patterns, db, k, db_ratio);
+}
+
+Handle MinerSCM::do_nisurp_top_k(Handle patterns, Handle db,
+                                 Handle k, Handle db_ratio)
+{
+	return surp_top_k("cog-nisurp-top-k", "nisurp", patterns, db, k, db_ratio);
+}
+
+Handle MinerSCM::do_surp_top_k(Handle mode, Handle patterns, Handle db,
+                               Handle k, Handle db_ratio)
+{
+	return surp_top_k("cog-surp-top-k", mode->get_name(), patterns, db, k,
+	                  db_ratio);
+}
+
+bool MinerSCM::set_restriction(MinerParameters& param,
+                               const std::string& name, double number)
+{
+	if (name == "maximum-conjuncts")
+		param.maximum_conjuncts = number <= 0 ? UINT_MAX : number;
+	else if (name == "maximum-variables")
+		param.maximum_variables = number;
+	else if (name == "maximum-cnjexp-variables")
+		param.maximum_cnjexp_variables = number;
+	else if (name == "maximum-spcial-conjuncts")
+		param.maximum_spcial_conjuncts = number;
+	else if (name == "enforce-specialization")
+		param.enforce_specialization = number != 0;
+	else
+		return false;
+	return true;
+}
+
+Handle MinerSCM::forest_to_atomese(const PatternForest& forest,
+                                   AtomSpace& as)
+{
+	// Parents precede their children
+	HandleSeq results;
+	for (unsigned i = 0; i < forest.size(); i++) {
+		Handle pattern = as.add_atom(forest.pattern(i));
+		MinerUtils::set_support(pattern, forest.support(i));
+		if (forest.parent(i) != PatternForest::npos)
+			MinerUtils::set_parent(pattern, results[forest.parent(i)]);
+		results.push_back(pattern);
+	}
+	return as.add_link(SET_LINK, std::move(results));
+}
+
+PatternForest MinerSCM::atomese_to_forest(
+	const Handle& patterns,
+	const std::function<unsigned(const Handle&)>& support)
+{
+	const HandleSeq& pats = patterns->getOutgoingSet();
+	HandleSet members(pats.begin(), pats.end());
+	std::unordered_map<Handle, unsigned> indices;
+	PatternForest forest;
+
+	// Add pattern after its parent, if any, and return its index
+	std::function<unsigned(const Handle&)> add = [&](const Handle& pattern) {
+		auto it = indices.find(pattern);
+		if (it != indices.end())
+			return it->second;
+		Handle parent = MinerUtils::get_parent(pattern);
+		unsigned parent_index =
+			parent and members.find(parent) != members.end() ?
+			add(parent) : PatternForest::npos;
+		unsigned i = forest.add(pattern, support(pattern), parent_index);
+		indices.emplace(pattern, i);
+		return i;
+	};
+	for (const Handle& pattern : pats)
+		add(pattern);
+	return forest;
+}
+
+Handle MinerSCM::surp_top_k(const std::string& prim, const std::string& mode,
+                            Handle patterns, Handle db, Handle k,
+                            Handle db_ratio)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as(prim.c_str());
+
+	// Fetch arguments
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	unsigned k_val = MinerUtils::get_uint(k);
+	double db_rat = MinerUtils::get_double(db_ratio);
+
+	Surprisingness::HandleDoubleSeq top =
+		Surprisingness::surp_top_k(mode, patterns->getOutgoingSet(), db_seq,
+		                           k_val, db_rat);
+
+	// Wrap each pattern in its surprisingness evaluation
+	Handle mode_h = asp->add_node(PREDICATE_NODE, std::string(mode));
+	HandleSeq surp_evals;
+	for (const auto& pat_surp : top) {
+		Handle surp_eval =
+			asp->add_link(EVALUATION_LINK, mode_h,
+			              asp->add_link(LIST_LINK, pat_surp.first, db));
+		surp_eval->setTruthValue(createSimpleTruthValue(pat_surp.second, 1.0));
+		surp_evals.push_back(surp_eval);
+	}
+	return asp->add_link(LIST_LINK, std::move(surp_evals));
+}
+
 TruthValuePtr MinerSCM::do_emp_tv(Handle pattern, Handle db, Handle db_ratio)
 {
 	// Fetch arguments
@@ -345,6 +939,164 @@ double MinerSCM::do_jsd(TruthValuePtr ltv, TruthValuePtr rtv)
 	return Surprisingness::jsd(ltv, rtv);
 }
 
+void MinerSCM::do_set_jsd_bins(Handle bins)
+{
+	Surprisingness::set_jsd_bins(MinerUtils::get_uint(bins));
+}
+
+Handle MinerSCM::do_mine_lattice(Handle db, Handle ms, Handle initpat,
+                                 Handle maxdepth)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-mine-lattice");
+
+	// Fetch arguments
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	MinerParameters param(MinerUtils::get_uint(ms), 1, initpat,
+	                      (int)MinerUtils::get_double(maxdepth));
+
+	Miner miner(param);
+	return miner.mine_lattice(db_seq).to_atomese(*asp);
+}
+
+Handle MinerSCM::do_mine_cpp(Handle db, Handle ms, Handle initpat,
+                             Handle options)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-mine-cpp");
+
+	// Fetch arguments
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	MinerParameters param(MinerUtils::get_uint(ms), 1, initpat);
+	Handle warm_start;
+	std::string snapshot;
+	unsigned workers = 0;
+	unsigned sample_size = 0;
+	double sample_lowering = 0.8;
+	for (const Handle& option : options->getOutgoingSet()) {
+		const std::string& name = option->getOutgoingAtom(0)->get_name();
+		const Handle& value = option->getOutgoingAtom(1);
+		double number = value->get_type() == NUMBER_NODE ?
+			MinerUtils::get_double(value) : 0.0;
+		if (set_restriction(param, name, number))
+			continue;
+		else if (name == "output-mode")
+			param.output_mode =
+				value->get_name() == "closed" ? MinerParameters::CLOSED
+				: value->get_name() == "maximal" ? MinerParameters::MAXIMAL
+				: MinerParameters::ALL;
+		else if (name == "top-k")
+			param.top_k = std::max(number, 0.0);
+		else if (name == "time-budget")
+			param.time_budget = std::max(number, 0.0);
+		else if (name == "memory-budget")
+			param.memory_budget = std::max(number, 0.0);
+		else if (name == "checkpoint")
+			param.checkpoint_file = value->get_name();
+		else if (name == "checkpoint-interval")
+			param.checkpoint_interval = number;
+		else if (name == "jobs")
+			param.jobs = std::max(number, 1.0);
+		else if (name == "valuations-chunk-size")
+			param.valuations_chunk_size = std::max(number, 0.0);
+		else if (name == "workers")
+			workers = std::max(number, 0.0);
+		else if (name == "sample-size")
+			sample_size = std::max(number, 0.0);
+		else if (name == "sample-lowering")
+			sample_lowering = number;
+		else if (name == "warm-start")
+			warm_start = value;
+		else if (name == "snapshot")
+			snapshot = value->get_name();
+		else
+			throw RuntimeException(TRACE_INFO, "Unknown option %s",
+			                       name.c_str());
+	}
+	if (0 < workers and 0 < sample_size)
+		throw RuntimeException(TRACE_INFO, "Options workers and sample-size "
+		                       "cannot be combined");
+	if (warm_start and (0 < workers or 0 < sample_size))
+		throw RuntimeException(TRACE_INFO, "Option warm-start cannot be "
+		                       "combined with workers nor sample-size");
+	if (1 < param.jobs and 0 < param.valuations_chunk_size)
+		throw RuntimeException(TRACE_INFO, "Options jobs and "
+		                       "valuations-chunk-size cannot be combined");
+
+	// Mine the data trees of the snapshot, if any, outside of the
+	// atomspace, streamed through a view of the snapshot if supported,
+	// otherwise all materialized at once
+	DbSnapshot dbs;
+	bool streamed = false;
+	if (not snapshot.empty()) {
+		dbs.open(snapshot);
+		streamed = 0 < param.valuations_chunk_size
+			and param.maximum_conjuncts <= 1 and param.checkpoint_file.empty()
+			and workers == 0 and sample_size == 0 and not warm_start;
+		if (not streamed)
+			db_seq = dbs.get_db();
+	}
+
+	// Mine the weighted db if members of db have multiplicities, see
+	// MinerUtils::get_weighted_db
+	HandleUCounter wdb;
+	if (snapshot.empty())
+		wdb = MinerUtils::get_weighted_db(db);
+	bool weighted = db_seq.size() < MinerUtils::db_size(wdb);
+	if (weighted and (0 < workers or 0 < sample_size or warm_start))
+		throw RuntimeException(TRACE_INFO, "A db with multiplicities cannot "
+		                       "be mined with workers, sample-size nor "
+		                       "warm-start");
+
+	// Previous patterns, under their memoized parents so that
+	// maxdepth is counted from their depths in the previous search,
+	// with their supports calculated if not memoized exactly, as they
+	// may have been cut off at the previous minimum support
+	PatternForest previous;
+	if (warm_start)
+		previous = atomese_to_forest(warm_start, [&](const Handle& pattern) {
+				return MinerUtils::exact_support(pattern, db_seq, param.jobs); });
+
+	PatternForest patterns;
+	if (0 < workers) {
+		// Workers materialize their own copy of the snapshot
+		MinerWorkers pool(param, db_seq, workers, snapshot);
+		patterns = pool.mine();
+	} else {
+		Miner miner(param);
+		patterns = warm_start ? miner.mine_warm_start(previous, db_seq)
+			: 0 < sample_size ? miner.mine_sample(db_seq, sample_size, sample_lowering)
+			: weighted ? miner.mine_forest(wdb)
+			: streamed ? miner.mine_forest(dbs.view())
+			: miner.mine_forest(db_seq);
+	}
+	return forest_to_atomese(patterns, *asp);
+}
+
+Handle MinerSCM::do_mine_incremental(Handle patterns, Handle db, Handle delta,
+                                     Handle ms, Handle initpat)
+{
+	AtomSpacePtr asp = SchemeSmob::ss_get_env_as("cog-mine-incremental");
+
+	// Fetch arguments
+	HandleSeq db_seq = MinerUtils::get_db(db);
+	const HandleSeq& delta_seq = delta->getOutgoingSet();
+	MinerParameters param(MinerUtils::get_uint(ms), 1, initpat);
+
+	// Previous patterns, with their supports over the previous db if
+	// not memoized exactly
+	HandleSet delta_set(delta_seq.begin(), delta_seq.end());
+	HandleSeq previous_db;
+	for (const Handle& dt : db_seq)
+		if (delta_set.find(dt) == delta_set.end())
+			previous_db.push_back(dt);
+	PatternForest previous =
+		atomese_to_forest(patterns, [&](const Handle& pattern) {
+				return MinerUtils::exact_support(pattern, previous_db); });
+
+	Miner miner(param);
+	return forest_to_atomese(miner.mine_incremental(previous, db_seq, delta_seq),
+	                         *asp);
+}
+
 Logger* MinerSCM::do_miner_logger()
 {
 	return &miner_logger();
@@ -23,6 +23,9 @@
 
 #include "MinerUtils.h"
 #include "MinerLogger.h"
+#include "MinerCache.h"
+#include "MatcherPool.h"
+#include "CountMinSketch.h"
 
 #include <opencog/util/dorepeat.h>
 #include <opencog/util/random.h>
@@ -51,6 +54,17 @@
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/algorithm/cxx11/all_of.hpp>
 #include <boost/algorithm/cxx11/any_of.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <tuple>
+
+#include <unistd.h>
 
 namespace opencog
 {
@@ -92,7 +106,8 @@ HandleSetSeq MinerUtils::shallow_abstract(const Valuations& valuations,
 HandleSet MinerUtils::focus_shallow_abstract(const Valuations& valuations,
                                              unsigned ms,
                                              bool enable_type,
-                                             bool enable_glob)
+                                             bool enable_glob,
+                                             bool approx)
 {
 	// If there are no valuations, then the result is empty by
 	// convention, regardless of the minimum support threshold.
@@ -117,47 +132,113 @@ HandleSet MinerUtils::focus_shallow_abstract(const Valuations& valuations,
 	// the value associated to variable, and associate the remaining
 	// valuations to it.
 	HandleSeqMap shapats;
+	// Number of valuations of var_scv encompassed by each shallow
+	// abstraction
+	HandleUCounter shapat_counts;
 	// Calculate how many valuations will be encompassed by these
 	// shallow abstractions
 	unsigned val_count = valuations.size() / var_scv.size();
-	for (const HandleSeq& valuation : var_scv.valuations) {
-		const Handle& value = var_scv.focus_value(valuation);
-
-		// If var_scv contains only one variable, then ignore shallow
-		// abstractions of nodes and nullary links as they create
-		// constant abstractions and
-		//
-		// 1. In case there is only one strongly connected component,
-		//    constant patterns cannot have support > 1.
-		//
-		// 2. In case there are more than one strongly connected
-		//    component, constant patterns are essentially useless
-		//    (don't affect the support), and they will no longer
-		//    reconnect, so they will remain useless.
-		//
-		// For these 2 reasons they can be safely ignored.
-		if (valuation.size() == 1 and is_nullary(value))
-			continue;
-
-		// Otherwise generate its shallow abstraction
-		if (Handle shabs = shallow_abstract_of_val(value))
-			shapats[shabs].push_back(value);
+	// Call fun on each value of the variable under focus and its
+	// count, see SCValuations::foreach_value.
+	auto foreach_value = [&](const std::function<void(const Handle&, unsigned)>& fun) {
+		var_scv.foreach_value(var_scv.focus_index(), fun);
+	};
+	// Counts are multiplied and summed in 64 bits, then saturated
+	// rather than wrapped around
+	auto saturate = [](uint64_t count) {
+		return (unsigned)std::min<uint64_t>(UINT_MAX, count);
+	};
+	auto product = [&](uint64_t l, uint64_t r) { return saturate(l * r); };
+
+	// If var_scv contains only one variable, then ignore shallow
+	// abstractions of nodes and nullary links as they create
+	// constant abstractions and
+	//
+	// 1. In case there is only one strongly connected component,
+	//    constant patterns cannot have support > 1.
+	//
+	// 2. In case there are more than one strongly connected
+	//    component, constant patterns are essentially useless
+	//    (don't affect the support), and they will no longer
+	//    reconnect, so they will remain useless.
+	//
+	// For these 2 reasons they can be safely ignored.
+	auto ignored = [&](const Handle& value) {
+		return var_scv.variables.size() == 1 and is_nullary(value);
+	};
+
+	if (approx and not enable_glob) {
+		// First pass, overestimate the count of each shallow
+		// abstraction, unless already done while streaming the
+		// valuations
+		CountMinSketch local_sketch;
+		if (not var_scv.is_sketched())
+			foreach_value([&](const Handle& value, unsigned count) {
+					if (not ignored(value))
+						local_sketch.add(shallow_abstract_key(value), count);
+				});
+		const CountMinSketch& sketch = var_scv.is_sketched() ?
+			var_scv.sketch(var_scv.focus_index()) : local_sketch;
+
+		// Second pass, abstract and exactly count the values passing
+		// the sketch. Link abstractions only depend on their type,
+		// arity and whether they are grounded predicate evaluations,
+		// so are built once per such triple.
+		std::map<std::tuple<Type, Arity, bool>, Handle> link_shabs;
+		foreach_value([&](const Handle& value, unsigned count) {
+				if (ignored(value))
+					return;
+				if (product(sketch.estimate(shallow_abstract_key(value)),
+				            val_count) < ms)
+					return;
+				Handle shabs;
+				if (is_nullary(value))
+					shabs = value;
+				else {
+					auto lk = std::make_tuple(value->get_type(),
+					                          value->get_arity(),
+					                          is_gpn_evaluation(value));
+					auto it = link_shabs.find(lk);
+					if (it == link_shabs.end())
+						it = link_shabs.insert({lk, shallow_abstract_of_val(value)}).first;
+					shabs = it->second;
+				}
+				if (shabs) {
+					shapats[shabs].push_back(value);
+					shapat_counts[shabs] += count;
+				}
+			});
+	}
+	else {
+		foreach_value([&](const Handle& value, unsigned count) {
+				if (ignored(value))
+					return;
+
+				// Otherwise generate its shallow abstraction
+				if (Handle shabs = shallow_abstract_of_val(value)) {
+					shapats[shabs].push_back(value);
+					shapat_counts[shabs] += count;
+				}
 
-		if (enable_glob)
-		{
-			HandleSeq shabs =
-					glob_shallow_abstract_of_val(value, var_scv.focus_variable(),
-					                             enable_type);
-			for (Handle s : shabs)
-				shapats[s].push_back(value);
-		}
+				if (enable_glob)
+				{
+					HandleSeq shabs =
+						glob_shallow_abstract_of_val(value, var_scv.focus_variable(),
+						                             enable_type);
+					for (Handle s : shabs) {
+						shapats[s].push_back(value);
+						shapat_counts[s] += count;
+					}
+				}
+			});
 	}
 
 	// Only consider shallow abstractions that reach the minimum
 	// support
 	for (const auto& shapat : shapats) {
-		if (ms <= shapat.second.size() * val_count) {
-			set_support(shapat.first, shapat.second.size() * val_count);
+		unsigned count = product(shapat_counts[shapat.first], val_count);
+		if (ms <= count) {
+			set_support(shapat.first, count);
 			shabs.insert(shapat);
 		}
 	}
@@ -196,6 +277,27 @@ HandleSet MinerUtils::focus_shallow_abstract(const Valuations& valuations,
 		if (not same_scv)
 			val_fac_count /= rv_scv.size();
 
+		// In streamed mode use the aggregated counters instead of
+		// the rows.
+		if (var_scv.is_streamed()) {
+			if (same_scv) {
+				rv_count = product(val_fac_count,
+				                   var_scv.eq_count(var_scv.focus_index(), rv_idx));
+			}
+			else {
+				for (const auto& vc : var_scv.values(var_scv.focus_index())) {
+					auto it = rv_vals.find(vc.first);
+					if (it != rv_vals.end())
+						rv_count = saturate((uint64_t)rv_count
+						                   + product(product(val_fac_count, vc.second),
+						                             it->second));
+					if (ms <= rv_count)
+						break;
+				}
+			}
+			continue;
+		}
+
 		for (const HandleSeq& valuation : var_scv.valuations) {
 			// Value associated to var
 			const Handle& val = valuation[var_scv.focus_index()];
@@ -204,13 +306,14 @@ HandleSet MinerUtils::focus_shallow_abstract(const Valuations& valuations,
 			// increase rv factorization count
 			if (same_scv) {
 				if (content_eq(val, valuation[rv_idx])) {
-					rv_count += val_fac_count;
+					rv_count = saturate((uint64_t)rv_count + val_fac_count);
 				}
 			}
 			else {
 				auto it = rv_vals.find(val);
 				if (it != rv_vals.end()) {
-					rv_count += val_fac_count * it->second;
+					rv_count = saturate((uint64_t)rv_count
+					                   + product(val_fac_count, it->second));
 				}
 			}
 
@@ -244,6 +347,26 @@ bool MinerUtils::is_nullary(const Handle& h)
 	return h->is_node() or h->get_arity() == 0;
 }
 
+size_t MinerUtils::shallow_abstract_key(const Handle& value)
+{
+	if (is_nullary(value))
+		return value->get_hash();
+
+	// Type, arity and whether it is a grounded predicate evaluation,
+	// see shallow_abstract_of_val
+	size_t key = 0;
+	boost::hash_combine(key, value->get_type());
+	boost::hash_combine(key, value->get_arity());
+	boost::hash_combine(key, is_gpn_evaluation(value));
+	return key;
+}
+
+bool MinerUtils::is_gpn_evaluation(const Handle& value)
+{
+	return value->get_type() == EVALUATION_LINK and
+		value->getOutgoingAtom(0)->get_type() == GROUNDED_PREDICATE_NODE;
+}
+
 Handle MinerUtils::shallow_abstract_of_val(const Handle& value)
 {
 	// Node or empty link, nothing to abstract
@@ -272,8 +395,7 @@ Handle MinerUtils::shallow_abstract_of_val(const Handle &value,
 
 	if (tt == BIND_LINK or       // TODO: should probabably be replaced
 	    // by scope link and its subtypes
-	    (tt == EVALUATION_LINK and
-	     value->getOutgoingAtom(0)->get_type() == GROUNDED_PREDICATE_NODE) or
+	    is_gpn_evaluation(value) or
 	    nameserver().isA(tt, FUNCTION_LINK) or
 	    nameserver().isA(tt, VIRTUAL_LINK)) {
 		// TODO: comment out the following lines when issue #1843 on the
@@ -442,6 +564,75 @@ HandleSeq MinerUtils::get_db(const Handle& db_cpt)
 	return db;
 }
 
+HandleUCounter MinerUtils::weigh_db(const HandleSeq& db)
+{
+	HandleUCounter wdb;
+	for (const Handle& dt : db)
+		wdb[dt]++;
+	return wdb;
+}
+
+HandleUCounter MinerUtils::get_weighted_db(const Handle& db_cpt)
+{
+	HandleUCounter wdb;
+	IncomingSet member_links = db_cpt->getIncomingSetByType(MEMBER_LINK);
+	for (const Handle& l : member_links) {
+		Handle member = l->getOutgoingAtom(0);
+		if (member != db_cpt)
+			wdb[member] += get_multiplicity(l);
+	}
+	return wdb;
+}
+
+HandleSeq MinerUtils::db_trees(const HandleUCounter& wdb)
+{
+	HandleSeq db;
+	db.reserve(wdb.size());
+	for (const auto& dtw : wdb)
+		db.push_back(dtw.first);
+	return db;
+}
+
+unsigned MinerUtils::db_size(const HandleUCounter& wdb)
+{
+	unsigned size = 0;
+	for (const auto& dtw : wdb)
+		size += dtw.second;
+	return size;
+}
+
+const Handle& MinerUtils::multiplicity_key()
+{
+	static Handle mk(createNode(NODE, "*-MultiplicityValueKey-*"));
+	return mk;
+}
+
+void MinerUtils::set_multiplicity(const Handle& member, unsigned multiplicity)
+{
+	FloatValuePtr mul_fv = createFloatValue((double)multiplicity);
+	member->setValue(multiplicity_key(), ValueCast(mul_fv));
+}
+
+unsigned MinerUtils::get_multiplicity(const Handle& member)
+{
+	FloatValuePtr mul_fv = FloatValueCast(member->getValue(multiplicity_key()));
+	return mul_fv ? (unsigned)mul_fv->value().front() : 1;
+}
+
+unsigned MinerUtils::valuation_weight(const Handle& pattern,
+                                      const HandleSeq& valuation,
+                                      const HandleUCounter& wdb)
+{
+	const Variables& vars = get_variables(pattern);
+	unsigned weight = 1;
+	for (const Handle& clause : get_clauses(pattern)) {
+		auto it = wdb.find(vars.substitute_nocheck(clause, valuation));
+		if (it != wdb.end())
+			weight *= it->second;
+	}
+	return weight;
+}
+
 unsigned MinerUtils::get_uint(const Handle& h)
 {
 	return (unsigned)std::round(get_double(h));
@@ -454,7 +645,8 @@ double MinerUtils::get_double(const Handle& h)
 
 unsigned MinerUtils::support(const Handle& pattern,
                              const HandleSeq& db,
-                             unsigned ms)
+                             unsigned ms,
+                             unsigned jobs)
 {
 	// Partition the pattern into strongly connected components
 	HandleSeq cps(get_component_patterns(pattern));
@@ -467,7 +659,7 @@ unsigned MinerUtils::support(const Handle& pattern,
 	std::vector<unsigned> freqs;
 	boost::transform(cps, std::back_inserter(freqs),
 	                 [&](const Handle& cp)
-	                 { return component_support(cp, db, ms); });
+	                 { return component_support(cp, db, ms, jobs); });
 
 	// Return the product of all frequencies
 	return boost::accumulate(freqs, 1, std::multiplies<unsigned>());
@@ -475,18 +667,70 @@ unsigned MinerUtils::support(const Handle& pattern,
 
 unsigned MinerUtils::component_support(const Handle& component,
                                        const HandleSeq& db,
-                                       unsigned ms)
+                                       unsigned ms,
+                                       unsigned jobs)
 {
 	if (totally_abstract(component))
 		return db.size();
-	return restricted_satisfying_set(component, db, ms)->get_arity();
+	return sharded_satisfying_set(component, db, jobs, ms)->get_arity();
+}
+
+unsigned MinerUtils::support(const Handle& pattern,
+                             const HandleUCounter& wdb,
+                             unsigned ms)
+{
+	HandleSeq cps(get_component_patterns(pattern));
+	if (cps.empty())
+	    return 1;
+	unsigned sup = 1;
+	for (const Handle& cp : cps)
+		sup *= component_support(cp, wdb, ms);
+	return sup;
+}
+
+unsigned MinerUtils::component_support(const Handle& component,
+                                       const HandleUCounter& wdb,
+                                       unsigned ms)
+{
+	if (totally_abstract(component) and n_conjuncts(component) == 1)
+		return db_size(wdb);
+
+	// Each valuation weighs at least 1, thus the weighted support
+	// reaches ms if ms valuations are found.
+	Handle satset = restricted_satisfying_set(component, db_trees(wdb), ms);
+	bool unary = get_variables(component).size() == 1;
+	unsigned sup = 0;
+	for (const Handle& vals : satset->getOutgoingSet())
+		sup += valuation_weight(component,
+		                        unary ? HandleSeq{vals} : vals->getOutgoingSet(),
+		                        wdb);
+	return sup;
+}
+
+std::vector<unsigned> MinerUtils::supports(const HandleSeq& patterns,
+                                           const HandleSeq& db)
+{
+	AtomSpacePtr tmp_db_as = createAtomSpace();
+	for (const Handle& dt : db)
+		tmp_db_as->add_atom(dt);
+
+	std::vector<unsigned> sups;
+	for (const Handle& pattern : patterns) {
+		unsigned sup = 1;
+		for (const Handle& cp : get_component_patterns(pattern))
+			sup *= totally_abstract(cp) ? db.size()
+				: restricted_satisfying_set(cp, tmp_db_as)->get_arity();
+		sups.push_back(sup);
+	}
+	return sups;
 }
 
 bool MinerUtils::enough_support(const Handle& pattern,
                                 const HandleSeq& db,
-                                unsigned ms)
+                                unsigned ms,
+                                unsigned jobs)
 {
-	return ms <= support_mem(pattern, db, ms);
+	return ms <= support_mem(pattern, db, ms, jobs);
 }
 
 HandleSetSeq MinerUtils::shallow_abstract(const Handle& pattern,
@@ -543,6 +787,41 @@ HandleSet MinerUtils::shallow_specialize(const Handle& pattern,
 	return results;
 }
 
+bool MinerUtils::is_closed(const Handle& pattern, const HandleSeq& db)
+{
+	return is_closed(Valuations(pattern, db));
+}
+
+bool MinerUtils::is_closed(const Valuations& valuations)
+{
+	return is_maximal(valuations, valuations.size());
+}
+
+bool MinerUtils::is_maximal(const Handle& pattern,
+                            const HandleSeq& db,
+                            unsigned ms)
+{
+	return is_maximal(Valuations(pattern, db), ms);
+}
+
+bool MinerUtils::is_maximal(const Valuations& valuations, unsigned ms)
+{
+	for (const HandleSet& shabs : shallow_abstract(valuations, ms, false, false, {}))
+		if (not shabs.empty())
+			return false;
+	return true;
+}
+
+size_t MinerUtils::resident_memory()
+{
+	// The second field of statm is the number of resident pages
+	std::ifstream statm("/proc/self/statm");
+	size_t size = 0, resident = 0;
+	if (not (statm >> size >> resident))
+		return 0;
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
 Handle MinerUtils::mk_body(const HandleSeq clauses)
 {
 	if (clauses.size() == 0)
@@ -621,7 +900,17 @@ Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
                                              const HandleSeq& db,
                                              unsigned ms)
 {
-	static AtomSpacePtr tmp_db_as = createAtomSpace(); // TODO: fix to be thread safe
+	// One temporary atomspace per thread, so that it can be called
+	// from several threads
+	static thread_local AtomSpacePtr tmp_db_as = createAtomSpace();
+	return restricted_satisfying_set(pattern, db, tmp_db_as, ms);
+}
+
+Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
+                                             const HandleSeq& db,
+                                             const AtomSpacePtr& tmp_db_as,
+                                             unsigned ms)
+{
 	tmp_db_as->clear();
 	HandleSeq tmp_db;
 	for (const auto& dt : db)
@@ -631,8 +920,15 @@ Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
 	if (totally_abstract(pattern) and n_conjuncts(pattern) == 1)
 		return tmp_db_as->add_link(SET_LINK, std::move(tmp_db));
 
+	return restricted_satisfying_set(pattern, tmp_db_as, ms);
+}
+
+Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
+                                             const AtomSpacePtr& db_as,
+                                             unsigned ms)
+{
 	// Define pattern to run
-	AtomSpacePtr tmp_query_as(createAtomSpace(tmp_db_as));
+	AtomSpacePtr tmp_query_as(createAtomSpace(db_as));
 	tmp_query_as->clear_copy_on_write(); // Ensure that _as is write-through
 	Handle tmp_pattern = tmp_query_as->add_atom(pattern),
 		vardecl = get_vardecl(tmp_pattern),
@@ -640,7 +936,7 @@ Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
 		gl = tmp_query_as->add_link(GET_LINK, vardecl, body);
 
 	// Run pattern matcher
-	SatisfyingSet sater(tmp_db_as.get());
+	SatisfyingSet sater(db_as.get());
 	sater.max_results = ms;
 	sater.satisfy(PatternLinkCast(gl));
 
@@ -649,6 +945,155 @@ Handle MinerUtils::restricted_satisfying_set(const Handle& pattern,
 	return Handle(createUnorderedLink(std::move(hs), SET_LINK));
 }
 
+void MinerUtils::foreach_valuation(const Handle& pattern,
+                                   const HandleSeq& db,
+                                   unsigned chunk_size,
+                                   const std::function<void(const HandleSeq&)>& fun)
+{
+	foreach_valuation(pattern, DbView(db), chunk_size, fun);
+}
+
+void MinerUtils::foreach_valuation(const Handle& pattern,
+                                   const DbView& db,
+                                   unsigned chunk_size,
+                                   const std::function<void(const HandleSeq&)>& fun)
+{
+	if (chunk_size == 0 or 1 < n_conjuncts(pattern))
+		chunk_size = db.size();
+
+	// Each data tree is a value, no need to call the pattern matcher
+	if (totally_abstract(pattern) and n_conjuncts(pattern) == 1)
+	{
+		for (size_t begin = 0; begin < db.size(); begin += chunk_size)
+			for (const Handle& dt :
+				     db.range(begin, std::min(db.size(), begin + chunk_size)))
+				fun({dt});
+		return;
+	}
+
+	bool chunked = chunk_size < db.size();
+	const Variables& vars = get_variables(pattern);
+	bool unary = vars.size() == 1;
+
+	// Groundings passed so far, and clause to ground to find the
+	// grounding of a valuation
+	HandleContentSizeMap passed;
+	Handle clause = chunked ? get_clauses(pattern).front() : Handle::UNDEFINED;
+
+	for (size_t begin = 0; begin < db.size(); begin += chunk_size)
+	{
+		HandleSeq chunk = db.range(begin, std::min(db.size(), begin + chunk_size));
+		Handle satset = restricted_satisfying_set(pattern, chunk);
+		for (const Handle& vals : satset->getOutgoingSet())
+		{
+			HandleSeq valuation = unary ? HandleSeq{vals} : vals->getOutgoingSet();
+			// Already passed by an earlier chunk
+			if (chunked and not passed.emplace(vars.substitute_nocheck(clause, valuation),
+			                                   begin).second)
+				continue;
+			fun(valuation);
+		}
+	}
+}
+
+void MinerUtils::foreach_grounding(const Handle& pattern,
+                                   const HandleSeq& db,
+                                   unsigned chunk_size,
+                                   const std::function<void(const Handle&)>& fun)
+{
+	foreach_grounding(pattern, DbView(db), chunk_size, fun);
+}
+
+void MinerUtils::foreach_grounding(const Handle& pattern,
+                                   const DbView& db,
+                                   unsigned chunk_size,
+                                   const std::function<void(const Handle&)>& fun)
+{
+	const Variables& vars = get_variables(pattern);
+	Handle clause = get_clauses(pattern).front();
+	foreach_valuation(pattern, db, chunk_size, [&](const HandleSeq& valuation) {
+			fun(vars.substitute_nocheck(clause, valuation)); });
+}
+
+void MinerUtils::record_subtrees(const Handle& tree, size_t position,
+                                 HandleContentSizeMap& positions)
+{
+	if (not positions.emplace(tree, position).second)
+		return;
+	if (tree->is_link())
+		for (const Handle& child : tree->getOutgoingSet())
+			record_subtrees(child, position, positions);
+}
+
+Handle MinerUtils::sharded_satisfying_set(const Handle& pattern,
+                                          const HandleSeq& db,
+                                          unsigned jobs,
+                                          unsigned ms)
+{
+	if (jobs < 2 or db.size() < 2 or 1 < n_conjuncts(pattern))
+		return restricted_satisfying_set(pattern, db, ms);
+
+	// Split the db into a few shards per job to balance the load
+	size_t n_shards = std::min(db.size(), (size_t)jobs * 4);
+	size_t shard_size = (db.size() + n_shards - 1) / n_shards;
+	jobs = std::min((size_t)jobs, n_shards);
+
+	std::atomic<size_t> next_shard(0);
+	std::atomic<bool> stop(false);
+	std::mutex merge_mtx;
+	std::unordered_multimap<ContentHash, Handle> index;
+	HandleSeq merged;
+
+	matcher_pool().run(jobs, [&](const AtomSpacePtr& tmp_db_as) {
+		// Atoms outside of any atomspace are taken over by the first
+		// atomspace they are added to, thus the pattern, and the data
+		// trees if outside of any atomspace, are copied by each thread
+		Handle tpat = copy_tree(pattern);
+		for (size_t i = next_shard++; i < n_shards and not stop; i = next_shard++)
+		{
+			size_t begin = i * shard_size;
+			if (db.size() <= begin)
+				break;
+			size_t end = std::min(db.size(), begin + shard_size);
+			HandleSeq shard;
+			for (size_t k = begin; k < end; k++)
+				shard.push_back(db[k]->getAtomSpace() ? db[k] : copy_tree(db[k]));
+			Handle satset = restricted_satisfying_set(tpat, shard, tmp_db_as, ms);
+
+			// Valuations of different threads are in different
+			// atomspaces, thus compared by content
+			std::lock_guard<std::mutex> lock(merge_mtx);
+			for (const Handle& vals : satset->getOutgoingSet())
+			{
+				if (ms <= merged.size())
+					break;
+				auto range = index.equal_range(vals->get_hash());
+				auto it = std::find_if(range.first, range.second,
+				                       [&](const auto& hv) {
+					                       return content_eq(hv.second, vals); });
+				if (it != range.second)
+					continue;
+				index.insert({vals->get_hash(), vals});
+				merged.push_back(vals);
+			}
+			if (ms <= merged.size())
+				stop = true;
+		}
+	});
+
+	return Handle(createUnorderedLink(std::move(merged), SET_LINK));
+}
+
+Handle MinerUtils::copy_tree(const Handle& tree)
+{
+	if (tree->is_node())
+		return createNode(tree->get_type(), std::string(tree->get_name()));
+	HandleSeq outgoing;
+	for (const Handle& child : tree->getOutgoingSet())
+		outgoing.push_back(copy_tree(child));
+	return createLink(std::move(outgoing), tree->get_type());
+}
+
 bool MinerUtils::totally_abstract(const Handle& pattern)
 {
 	// Check whether it is an abstraction to begin with
@@ -1251,9 +1696,12 @@ const Handle& MinerUtils::support_key()
 	return ck;
 }
 
-void MinerUtils::set_support(const Handle& pattern, double support)
+void MinerUtils::set_support(const Handle& pattern, double support,
+                             unsigned ms)
 {
-	FloatValuePtr support_fv = createFloatValue(boost::numeric_cast<double>(support));
+	FloatValuePtr support_fv = ms == UINT_MAX ?
+		createFloatValue(boost::numeric_cast<double>(support))
+		: createFloatValue(std::vector<double>{support, (double)ms});
 	pattern->setValue(support_key(), ValueCast(support_fv));
 }
 
@@ -1265,18 +1713,64 @@ double MinerUtils::get_support(const Handle& pattern)
 	return -1.0;
 }
 
-double MinerUtils::support_mem(const Handle& pattern,
-                               const HandleSeq& db,
-                               unsigned ms)
+bool MinerUtils::get_support(const Handle& pattern, const HandleSeq& db,
+                             unsigned ms, double& support)
 {
-	double sup = get_support(pattern);
-	if (sup < 0) {
-		sup = support(pattern, db, ms);
-		set_support(pattern, sup);
+	FloatValuePtr support_fv = FloatValueCast(pattern->getValue(support_key()));
+	if (support_fv) {
+		// A support below the minimum support it has been calculated
+		// with is exact, otherwise it is only known to reach it.
+		const std::vector<double>& values = support_fv->value();
+		if (values.size() < 2 or values[0] < values[1] or ms <= values[1]) {
+			support = values[0];
+			return true;
+		}
 	}
+	return miner_cache().get_support(pattern, db, ms, support);
+}
+
+double MinerUtils::support_mem(const Handle& pattern,
+                               const HandleSeq& db,
+                               unsigned ms,
+                               unsigned jobs)
+{
+	double sup;
+	if (get_support(pattern, db, ms, sup))
+		return sup;
+	sup = support(pattern, db, ms, jobs);
+	// Memoize in the miner cache if open, not to grow the pattern
+	// atom
+	if (not miner_cache().set_support(pattern, db, ms, sup))
+		set_support(pattern, sup, ms);
 	return sup;
 }
 
+const Handle& MinerUtils::parent_key()
+{
+	static Handle pk(createNode(NODE, "*-ParentValueKey-*"));
+	return pk;
+}
+
+void MinerUtils::set_parent(const Handle& pattern, const Handle& parent)
+{
+	pattern->setValue(parent_key(), ValueCast(parent));
+}
+
+Handle MinerUtils::get_parent(const Handle& pattern)
+{
+	return HandleCast(pattern->getValue(parent_key()));
+}
+
+unsigned MinerUtils::exact_support(const Handle& pattern,
+                                   const HandleSeq& db,
+                                   unsigned jobs)
+{
+	double sup;
+	if (get_support(pattern, db, UINT_MAX, sup))
+		return sup;
+	return support(pattern, db, UINT_MAX, jobs);
+}
+
 void MinerUtils::remove_if(HandleSeq& clauses,
                            std::function<bool(const Handle&, const HandleSeq&)> fun)
 {
@@ -23,10 +23,15 @@
 #ifndef OPENCOG_MINER_UTILS_H_
 #define OPENCOG_MINER_UTILS_H_
 
+#include <functional>
+#include <unordered_map>
+
 #include <opencog/util/empty_string.h>
+#include <opencog/atoms/base/Atom.h>
 #include <opencog/atoms/base/Handle.h>
 #include <opencog/unify/Unify.h>
 
+#include "DbView.h"
 #include "Valuations.h"
 
 namespace opencog
@@ -36,6 +41,25 @@ typedef std::vector<HandleSeqSeq> HandleSeqSeqSeq;
 typedef std::pair<HandleSet, GlobInterval> ValIntvlPair;
 typedef std::map<Handle, ValIntvlPair> HandleValIntvlMap;
 
+/**
+ * Hash and equality of atoms by content, so that atoms of different
+ * atomspaces, or outside of any, can be looked up together.
+ */
+struct HandleContentHash
+{
+	size_t operator()(const Handle& h) const { return h->get_hash(); }
+};
+struct HandleContentEqual
+{
+	bool operator()(const Handle& l, const Handle& r) const
+	{
+		return content_eq(l, r);
+	}
+};
+typedef std::unordered_map<Handle, size_t,
+                           HandleContentHash,
+                           HandleContentEqual> HandleContentSizeMap;
+
 /**
  * Collection of static methods for the pattern miner.
  */
@@ -109,10 +133,37 @@ public:
 	 *                                          (Inheritance
 	 *                                            (Variable "$X1")
 	 *                                            (Variable "$X2"))) }
+	 *
+	 * If approx is true, then the shallow abstractions are first
+	 * counted with a Count-Min sketch (see CountMinSketch), keyed by
+	 * shallow_abstract_key, which never underestimates counts. Only
+	 * values whose key passes the sketch are abstracted and exactly
+	 * counted in a second pass, thus the result is the same, but
+	 * abstractions unlikely to reach ms are never built nor stored
+	 * with their values. This is ignored if enable_glob is true. If
+	 * the valuations of the focus variable are sketched (see
+	 * SCValuations), the sketch fed as they were streamed is used,
+	 * and the second pass streams them again, so that the values not
+	 * passing the sketch are never held in memory at all.
 	 */
 	static HandleSet focus_shallow_abstract(const Valuations &valuations,
 	                                        unsigned ms, bool enable_type,
-	                                        bool enable_glob);
+	                                        bool enable_glob,
+	                                        bool approx=false);
+
+	/**
+	 * Return a hash identifying the shallow abstraction of value
+	 * without building it. That is the content hash of value if it is
+	 * nullary, otherwise a hash of its type, arity and whatever else
+	 * shallow_abstract_of_val depends on.
+	 */
+	static size_t shallow_abstract_key(const Handle& value);
+
+	/**
+	 * Return true iff value is an EvaluationLink of a
+	 * GroundedPredicateNode.
+	 */
+	static bool is_gpn_evaluation(const Handle& value);
 
 	/**
 	 * Return true iff h is a node or a nullary link.
@@ -201,6 +252,60 @@ public:
 	 */
 	static HandleSeq get_db(const Handle& db_cpt);
 
+	/**
+	 * Weighted db, where identical data trees are collapsed into one
+	 * with their multiplicity, to shrink the number of data trees to
+	 * go through. The weighted versions of support, Valuations and
+	 * Surprisingness::universe_count over a weighted db give the same
+	 * results as their unweighted versions over the db where each
+	 * data tree occurs as many times as its multiplicity, as
+	 * distinct data trees (e.g. coming from different sources).
+	 *
+	 * Given a db, return its weighted db, collapsing duplicates.
+	 */
+	static HandleUCounter weigh_db(const HandleSeq& db);
+
+	/**
+	 * Given a db concept node, retrieve all its members with their
+	 * multiplicities, see get_multiplicity.
+	 */
+	static HandleUCounter get_weighted_db(const Handle& db_cpt);
+
+	/**
+	 * Return the distinct data trees of a weighted db.
+	 */
+	static HandleSeq db_trees(const HandleUCounter& wdb);
+
+	/**
+	 * Return the size of a weighted db, that is the sum of the
+	 * multiplicities of its data trees.
+	 */
+	static unsigned db_size(const HandleUCounter& wdb);
+
+	/**
+	 * Return an atom to serve as key to store the multiplicity of a
+	 * data tree in a db, on the member link between them.
+	 */
+	static const Handle& multiplicity_key();
+
+	/**
+	 * Set/get the multiplicity of a data tree in a db, given the
+	 * member link between them, 1 if not set.
+	 */
+	static void set_multiplicity(const Handle& member, unsigned multiplicity);
+	static unsigned get_multiplicity(const Handle& member);
+
+	/**
+	 * Return the weight of a valuation of pattern (tuple of values
+	 * ordered as its variables) over a weighted db, that is the
+	 * product of the multiplicities of the data trees its clauses
+	 * are instantiated to. Instantiated clauses that are not data
+	 * trees of wdb, but subtrees, count as 1.
+	 */
+	static unsigned valuation_weight(const Handle& pattern,
+	                                 const HandleSeq& valuation,
+	                                 const HandleUCounter& wdb);
+
 	/**
 	 * Return the non-negative integer held by a number node.
 	 */
@@ -214,10 +319,15 @@ public:
 	/**
 	 * Given a pattern and a db, calculate the pattern frequency up to
 	 * ms (to avoid unnecessary calculations).
+	 *
+	 * If jobs is above 1, the satisfying sets of the single conjunct
+	 * components are calculated over shards of the db on that many
+	 * threads, see sharded_satisfying_set.
 	 */
 	static unsigned support(const Handle& pattern,
 	                        const HandleSeq& db,
-	                        unsigned ms);
+	                        unsigned ms,
+	                        unsigned jobs=1);
 
 	/**
 	 * Like support but assumes that pattern is strongly connected (all
@@ -225,8 +335,28 @@ public:
 	 */
 	static unsigned component_support(const Handle& pattern,
 	                                  const HandleSeq& db,
+	                                  unsigned ms,
+	                                  unsigned jobs=1);
+
+	/**
+	 * Like support and component_support over a weighted db, each
+	 * valuation counting as its weight, see valuation_weight.
+	 */
+	static unsigned support(const Handle& pattern,
+	                        const HandleUCounter& wdb,
+	                        unsigned ms);
+	static unsigned component_support(const Handle& pattern,
+	                                  const HandleUCounter& wdb,
 	                                  unsigned ms);
 
+	/**
+	 * Return the supports of the given patterns over db, in one batch,
+	 * db being copied once into a temporary atomspace, then matched
+	 * by each pattern, rather than copied again for each of them.
+	 */
+	static std::vector<unsigned> supports(const HandleSeq& patterns,
+	                                      const HandleSeq& db);
+
 	/**
 	 * Calculate if the pattern has enough support w.r.t. to the given
 	 * db, that is whether its frequency is greater than or equal
@@ -234,7 +364,8 @@ public:
 	 */
 	static bool enough_support(const Handle& pattern,
 	                           const HandleSeq& db,
-	                           unsigned ms);
+	                           unsigned ms,
+	                           unsigned jobs=1);
 
 	/**
 	 * Like shallow_abstract(const Valuations&, unsigned) but takes a pattern
@@ -280,6 +411,43 @@ public:
 	                                    bool enable_glob=false,
 	                                    const HandleSeq& ignore_vars={});
 
+	/**
+	 * Return true iff pattern is closed w.r.t. db, that is none of its
+	 * shallow specializations has the same support. Since any
+	 * specialization obtained by composition has a shallow
+	 * specialization of greater or equal support, this is equivalent
+	 * to having no specialization of equal support, conjunction
+	 * expansions aside.
+	 */
+	static bool is_closed(const Handle& pattern, const HandleSeq& db);
+
+	/**
+	 * Like above, given the valuations of the pattern.
+	 */
+	static bool is_closed(const Valuations& valuations);
+
+	/**
+	 * Return true iff pattern is maximal w.r.t. db and ms, that is
+	 * none of its shallow specializations has support ms or above
+	 * (which, as for is_closed, is equivalent to having no frequent
+	 * specialization).
+	 */
+	static bool is_maximal(const Handle& pattern,
+	                       const HandleSeq& db,
+	                       unsigned ms);
+
+	/**
+	 * Like above, given the valuations of the pattern.
+	 */
+	static bool is_maximal(const Valuations& valuations, unsigned ms);
+
+	/**
+	 * Return the resident memory of the current process in bytes, or
+	 * 0 if it cannot be determined (only supported on Linux as of
+	 * now).
+	 */
+	static size_t resident_memory();
+
 	/**
 	 * Create a pattern body from clauses, introducing an AndLink if
 	 * necessary.
@@ -357,6 +525,104 @@ public:
 	                                        const HandleSeq& db,
 	                                        unsigned ms=UINT_MAX);
 
+	/**
+	 * Like above but copy db into tmp_db_as, cleared beforehand,
+	 * instead of a temporary atomspace of the calling thread.
+	 */
+	static Handle restricted_satisfying_set(const Handle& pattern,
+	                                        const HandleSeq& db,
+	                                        const AtomSpacePtr& tmp_db_as,
+	                                        unsigned ms=UINT_MAX);
+
+	/**
+	 * Like above over the atoms already in db_as, left untouched.
+	 */
+	static Handle restricted_satisfying_set(const Handle& pattern,
+	                                        const AtomSpacePtr& db_as,
+	                                        unsigned ms=UINT_MAX);
+
+	/**
+	 * Return a copy of tree sharing no atom with it, so that both can
+	 * be added to different atomspaces concurrently.
+	 */
+	static Handle copy_tree(const Handle& tree);
+
+	/**
+	 * Like restricted_satisfying_set but, rather than returning the
+	 * satisfying set, call fun on each of its valuations (tuple of
+	 * values ordered as the variables of pattern). The db is processed
+	 * chunk_size data trees at a time, so that only the groundings of
+	 * a chunk are held in memory at once.
+	 *
+	 * Groundings of a multi-conjunct pattern may span data trees of
+	 * different chunks, thus such patterns are processed over the
+	 * whole db at once. A grounding of a single conjunct pattern may
+	 * be a subtree shared by data trees of different chunks, it is
+	 * only passed to fun by the first chunk finding it. To that end
+	 * the passed groundings are recorded, compared by content, so
+	 * that db may be outside of any atomspace, like the data trees of
+	 * a DbSnapshot, while the data trees of the processed chunks are
+	 * not retained.
+	 *
+	 * If chunk_size is zero, then the whole db is processed at once.
+	 */
+	static void foreach_valuation(const Handle& pattern,
+	                              const HandleSeq& db,
+	                              unsigned chunk_size,
+	                              const std::function<void(const HandleSeq&)>& fun);
+
+	/**
+	 * Like above over a view of a db, only materializing the data
+	 * trees of one chunk at a time, see DbView.
+	 */
+	static void foreach_valuation(const Handle& pattern,
+	                              const DbView& db,
+	                              unsigned chunk_size,
+	                              const std::function<void(const HandleSeq&)>& fun);
+
+	/**
+	 * Call fun on the grounding of the clause of pattern, a single
+	 * conjunct, by each valuation of pattern over db, see
+	 * foreach_valuation, thus once per distinct grounding, except for
+	 * a totally abstract pattern, whose groundings are the data trees.
+	 */
+	static void foreach_grounding(const Handle& pattern,
+	                              const HandleSeq& db,
+	                              unsigned chunk_size,
+	                              const std::function<void(const Handle&)>& fun);
+	static void foreach_grounding(const Handle& pattern,
+	                              const DbView& db,
+	                              unsigned chunk_size,
+	                              const std::function<void(const Handle&)>& fun);
+
+	/**
+	 * Map tree and its subtrees that are not in positions yet to
+	 * position. Subtrees already in positions are not visited, as
+	 * their own subtrees are then in it as well, so that recording
+	 * all data trees of a db only visits each distinct subtree once.
+	 */
+	static void record_subtrees(const Handle& tree, size_t position,
+	                            HandleContentSizeMap& positions);
+
+	/**
+	 * Like restricted_satisfying_set but the db is split into shards
+	 * matched on jobs threads of matcher_pool(), each with its own
+	 * temporary atomspace and copy of the pattern, the shard-local
+	 * satisfying sets being then merged. A grounding shared by data
+	 * trees of different shards is only kept once, compared by
+	 * content. Workers stop picking shards
+	 * once ms valuations have been merged, and the result is
+	 * truncated to ms valuations.
+	 *
+	 * Groundings of a multi-conjunct pattern may span data trees of
+	 * different shards, thus such patterns, as well as jobs below 2,
+	 * fall back to restricted_satisfying_set over the whole db.
+	 */
+	static Handle sharded_satisfying_set(const Handle& pattern,
+	                                     const HandleSeq& db,
+	                                     unsigned jobs,
+	                                     unsigned ms=UINT_MAX);
+
 	/**
 	 * Return true iff the pattern is totally abstract like
 	 *
@@ -791,25 +1057,74 @@ public:
 	 * encoded as double because it is stored as a FloatValue, and its
 	 * subsequent processing (probability estimate, etc) requires a
 	 * double anyway.
+	 *
+	 * If the support has been calculated up to ms (see support), ms
+	 * is stored along with it, as the second element of the
+	 * FloatValue, so that it is only reused for minimum supports it
+	 * is valid for, see
+	 * get_support(const Handle&, const HandleSeq&, unsigned, double&).
 	 */
-	static void set_support(const Handle& pattern, double support);
+	static void set_support(const Handle& pattern, double support,
+	                        unsigned ms=UINT_MAX);
 
 	/**
 	 * Get the support of a pattern stored as associated value to
-	 * support_key(). If no such value exist then return -1.0.
+	 * support_key(). If no such value exist then return -1.0. The support may have been calculated up to
+	 * some ms, thus only be a lower bound of the actual support.
 	 */
 	static double get_support(const Handle& pattern);
 
+	/**
+	 * Like get_support, or else look up the support of pattern over
+	 * db in miner_cache(), but only if the stored support is usable
+	 * with ms, that is if it is exact (below the ms it has been
+	 * calculated with), or has been calculated with an ms greater
+	 * than or equal to the given one. Return true iff such a support
+	 * is found, then stored in support.
+	 */
+	static bool get_support(const Handle& pattern, const HandleSeq& db,
+	                        unsigned ms, double& support);
+
+	/**
+	 * Return an atom to serve as key to store the parent of a pattern
+	 * in the forest it has been mined in.
+	 */
+	static const Handle& parent_key();
+
+	/**
+	 * Attach to pattern its parent, both in the same atomspace, so
+	 * that the forest of mined patterns, and the depth of each
+	 * pattern, can be restored from a set of them.
+	 */
+	static void set_parent(const Handle& pattern, const Handle& parent);
+
+	/**
+	 * Return the parent attached to pattern, Handle::UNDEFINED if
+	 * none.
+	 */
+	static Handle get_parent(const Handle& pattern);
+
 	/**
 	 * Like get_support, but if there is no value associated to
-	 * support_key() then calculate and set the support.
-	 *
-	 * Warning: note that the support is gonna be up to ms, so such
-	 * memoization should not be used if ms is to be changed.
+	 * support_key() nor support in miner_cache() usable with ms,
+	 * then calculate the support up to ms and memoize it, along with
+	 * ms, in miner_cache() if open, or set it otherwise.
 	 */
 	static double support_mem(const Handle& pattern,
 	                          const HandleSeq& db,
-	                          unsigned ms);
+	                          unsigned ms,
+	                          unsigned jobs=1);
+
+	/**
+	 * Return the exact support of pattern over db, memoized if it has
+	 * been calculated with no lower minimum support than itself (see
+	 * get_support(const Handle&, const HandleSeq&, unsigned, double&)),
+	 * and otherwise calculated without memoizing it, as the supports
+	 * memoized as pattern values may not refer to db.
+	 */
+	static unsigned exact_support(const Handle& pattern,
+	                              const HandleSeq& db,
+	                              unsigned jobs=1);
 
 	/**
 	 * Remove every element of clauses such that
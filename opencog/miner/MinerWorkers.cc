@@ -0,0 +1,358 @@
+/*
+ * MinerWorkers.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "MinerWorkers.h"
+#include "MinerCheckpoint.h"
+#include "MinerLogger.h"
+#include "MinerUtils.h"
+#include "DbSnapshot.h"
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/oc_assert.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace opencog
+{
+
+MinerWorkers::MinerWorkers(const MinerParameters& param, const HandleSeq& db,
+                           unsigned n_workers, const std::string& snapshot_file)
+	: _param(param), _db(db)
+{
+	OC_ASSERT(param.output_mode == MinerParameters::ALL and
+	          param.top_k == 0 and param.maximum_conjuncts <= 1 and
+	          not param.score and param.checkpoint_file.empty(),
+	          "Mining over worker processes only supports the ALL output "
+	          "mode, without top-k, conjunction expansion, score nor "
+	          "checkpoint");
+	OC_ASSERT(0 < n_workers, "At least one worker is required");
+
+	// The destructor is not called if the constructor throws, thus
+	// the workers already forked are shut down before throwing
+	auto fail = [&](const char* what) {
+		std::string error(strerror(errno));
+		shutdown();
+		throw RuntimeException(TRACE_INFO, "%s: %s", what, error.c_str());
+	};
+	for (unsigned i = 0; i < n_workers; i++) {
+		int sv[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+			fail("Cannot create worker socket");
+		pid_t pid = fork();
+		if (pid < 0) {
+			int fork_errno = errno;
+			::close(sv[0]);
+			::close(sv[1]);
+			errno = fork_errno;
+			fail("Cannot fork worker");
+		}
+		if (pid == 0) {
+			// Worker process, only keep its end of its own socket, so
+			// that the closing of the coordinator ends is noticed
+			::close(sv[0]);
+			for (const Worker& worker : _workers)
+				::close(worker.fd);
+			// Only the forking thread survives a fork, the threads of
+			// matcher_pool() are not running in the worker, thus it
+			// must not shard over them
+			_param.jobs = 1;
+			int status = 0;
+			try {
+				if (snapshot_file.empty()) {
+					serve(sv[1], _db);
+				} else {
+					DbSnapshot snapshot;
+					snapshot.open(snapshot_file);
+					_db.clear();
+					serve(sv[1], snapshot.get_db());
+				}
+			} catch (const std::exception& ex) {
+				write_line(sv[1], std::string("error ") + ex.what());
+				status = 1;
+			}
+			_exit(status);
+		}
+		::close(sv[1]);
+		_workers.push_back({pid, sv[0], ""});
+	}
+	LAZY_MINER_LOG_DEBUG << "Forked " << _workers.size() << " miner workers";
+}
+
+MinerWorkers::~MinerWorkers()
+{
+	shutdown();
+}
+
+void MinerWorkers::shutdown()
+{
+	// Closing the sockets ends the idle workers, those that have not
+	// exited after the grace period are terminated
+	for (const Worker& worker : _workers)
+		::close(worker.fd);
+	std::vector<pid_t> running;
+	for (const Worker& worker : _workers)
+		running.push_back(worker.pid);
+	_workers.clear();
+
+	auto exited = [](pid_t pid) {
+		pid_t r;
+		while ((r = waitpid(pid, nullptr, WNOHANG)) < 0 and errno == EINTR);
+		return r != 0;
+	};
+	for (unsigned waited = 0; true; waited += shutdown_poll_ms) {
+		running.erase(std::remove_if(running.begin(), running.end(), exited),
+		              running.end());
+		if (running.empty() or shutdown_grace_ms <= waited)
+			break;
+		usleep(shutdown_poll_ms * 1000);
+	}
+	for (pid_t pid : running)
+		kill(pid, SIGTERM);
+	for (pid_t pid : running)
+		while (waitpid(pid, nullptr, 0) < 0 and errno == EINTR);
+}
+
+PatternForest MinerWorkers::mine()
+{
+	// The shallow specializations are mined by the coordinator
+	MinerParameters shallow_param(_param);
+	shallow_param.maxdepth = 1;
+	PatternForest patterns = Miner(shallow_param).mine_forest(_db);
+	if (_param.maxdepth == 1)
+		return patterns;
+
+	// The subtree of each is mined by a worker, all are roots
+	std::vector<std::string> requests;
+	for (unsigned i = 0; i < patterns.size(); i++)
+		requests.push_back("mine " + MinerCheckpoint::encode_atom(patterns.pattern(i)));
+	std::vector<std::vector<std::string>> responses = dispatch(requests);
+
+	for (size_t r = 0; r < responses.size(); r++) {
+		PatternForest subtree;
+		for (const std::string& line : responses[r]) {
+			std::istringstream ls(line);
+			std::string kind;
+			int parent;
+			unsigned support;
+			if (not (ls >> kind >> parent >> support) or kind != "pattern"
+			    or parent >= (int)subtree.size())
+				throw RuntimeException(TRACE_INFO, "Ill-formed worker response: %s",
+				                       line.c_str());
+			size_t pos = ls.tellg();
+			Handle pattern = MinerCheckpoint::decode_atom(line, pos);
+			subtree.add(pattern, support,
+			            parent < 0 ? PatternForest::npos : parent);
+		}
+		patterns.merge(std::move(subtree), r);
+	}
+	return patterns;
+}
+
+std::vector<unsigned> MinerWorkers::supports(const HandleSeq& patterns,
+                                             unsigned ms)
+{
+	std::vector<std::string> requests;
+	for (const Handle& pattern : patterns)
+		requests.push_back("support " + std::to_string(ms) + " "
+		                   + MinerCheckpoint::encode_atom(pattern));
+	std::vector<std::vector<std::string>> responses = dispatch(requests);
+
+	std::vector<unsigned> sups;
+	for (const std::vector<std::string>& response : responses) {
+		std::istringstream ls(response.empty() ? "" : response.front());
+		std::string kind;
+		unsigned support;
+		if (not (ls >> kind >> support) or kind != "support")
+			throw RuntimeException(TRACE_INFO, "Ill-formed worker response");
+		sups.push_back(support);
+	}
+	return sups;
+}
+
+unsigned MinerWorkers::size() const
+{
+	return _workers.size();
+}
+
+std::vector<std::vector<std::string>>
+MinerWorkers::dispatch(const std::vector<std::string>& requests)
+{
+	if (_workers.empty())
+		throw RuntimeException(TRACE_INFO, "The miner workers are shut down");
+	std::vector<std::vector<std::string>> responses(requests.size());
+
+	// The responses of the busy workers would be left unread, thus
+	// the pool is shut down before throwing
+	auto fail = [&](const std::string& error) {
+		shutdown();
+		throw RuntimeException(TRACE_INFO, "%s", error.c_str());
+	};
+
+	// Index of the request processed by each worker, -1 if idle
+	std::vector<int> assigned(_workers.size(), -1);
+	size_t next = 0;
+	unsigned busy = 0;
+	auto assign = [&](size_t w) {
+		if (next == requests.size())
+			return;
+		if (not write_line(_workers[w].fd, requests[next]))
+			fail("Cannot send request to worker "
+			     + std::to_string(_workers[w].pid));
+		assigned[w] = next++;
+		busy++;
+	};
+	for (size_t w = 0; w < _workers.size(); w++)
+		assign(w);
+
+	while (0 < busy) {
+		std::vector<pollfd> fds;
+		std::vector<size_t> polled;
+		for (size_t w = 0; w < _workers.size(); w++) {
+			if (assigned[w] < 0)
+				continue;
+			fds.push_back({_workers[w].fd, POLLIN, 0});
+			polled.push_back(w);
+		}
+		if (poll(fds.data(), fds.size(), -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			fail(std::string("Cannot poll workers: ") + strerror(errno));
+		}
+
+		// Workers write their responses all at once, read the whole
+		// response of each ready worker, then give it the next request
+		for (size_t f = 0; f < fds.size(); f++) {
+			if (fds[f].revents == 0)
+				continue;
+			size_t w = polled[f];
+			std::vector<std::string>& response = responses[assigned[w]];
+			std::string line;
+			while (true) {
+				if (not read_line(_workers[w].fd, _workers[w].buffer, line))
+					fail("Worker " + std::to_string(_workers[w].pid)
+					     + " terminated");
+				if (line == "done")
+					break;
+				if (line.compare(0, 6, "error ") == 0)
+					fail("Worker " + std::to_string(_workers[w].pid)
+					     + " failed: " + line.substr(6));
+				response.push_back(line);
+			}
+			assigned[w] = -1;
+			busy--;
+			assign(w);
+		}
+	}
+	return responses;
+}
+
+void MinerWorkers::serve(int fd, const HandleSeq& db) const
+{
+	std::string buffer, request;
+	while (read_line(fd, buffer, request)) {
+		std::string response;
+		try {
+			response = answer(request, db);
+		} catch (const std::exception& ex) {
+			response = std::string("error ") + ex.what();
+		}
+		if (not write_line(fd, response))
+			return;
+	}
+}
+
+std::string MinerWorkers::answer(const std::string& request,
+                                 const HandleSeq& db) const
+{
+	std::istringstream rs(request);
+	std::string kind;
+	rs >> kind;
+	std::stringstream response;
+	if (kind == "mine") {
+		size_t pos = rs.tellg();
+		MinerParameters param(_param);
+		param.initpat = MinerCheckpoint::decode_atom(request, pos);
+		param.maxdepth = _param.maxdepth < 0 ? -1 : _param.maxdepth - 1;
+		PatternForest patterns = Miner(param).mine_forest(db);
+		for (unsigned i = 0; i < patterns.size(); i++)
+			response << "pattern " << (int)patterns.parent(i) << " "
+			         << patterns.support(i) << " "
+			         << MinerCheckpoint::encode_atom(patterns.pattern(i)) << "\n";
+	} else if (kind == "support") {
+		unsigned ms;
+		if (not (rs >> ms))
+			throw RuntimeException(TRACE_INFO, "Ill-formed request: %s",
+			                       request.c_str());
+		size_t pos = rs.tellg();
+		Handle pattern = MinerCheckpoint::decode_atom(request, pos);
+		response << "support " << MinerUtils::support(pattern, db, ms) << "\n";
+	} else {
+		throw RuntimeException(TRACE_INFO, "Unknown request: %s",
+		                       request.c_str());
+	}
+	response << "done";
+	return response.str();
+}
+
+bool MinerWorkers::write_line(int fd, const std::string& line)
+{
+	std::string data = line + "\n";
+	for (size_t sent = 0; sent < data.size();) {
+		// Do not raise SIGPIPE if the other end is closed
+		ssize_t n = send(fd, data.data() + sent, data.size() - sent,
+		                 MSG_NOSIGNAL);
+		if (n < 0 and errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		sent += n;
+	}
+	return true;
+}
+
+bool MinerWorkers::read_line(int fd, std::string& buffer, std::string& line)
+{
+	size_t eol;
+	while ((eol = buffer.find('\n')) == std::string::npos) {
+		char chunk[4096];
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n < 0 and errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		buffer.append(chunk, n);
+	}
+	line = buffer.substr(0, eol);
+	buffer.erase(0, eol + 1);
+	return true;
+}
+
+} // namespace opencog
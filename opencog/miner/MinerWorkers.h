@@ -0,0 +1,182 @@
+/*
+ * MinerWorkers.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OPENCOG_MINER_WORKERS_H_
+#define OPENCOG_MINER_WORKERS_H_
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include <opencog/atoms/base/Handle.h>
+
+#include "Miner.h"
+#include "PatternForest.h"
+
+namespace opencog
+{
+
+/**
+ * Pool of local worker processes, each holding its own copy of the
+ * db, to which a coordinator, the process creating the pool,
+ * distributes mining requests, so that the search is not bounded by
+ * the heap and garbage collector of a single process.
+ *
+ * Workers are forked when the pool is created. When it is destroyed
+ * their sockets are closed, so that idle workers exit, those that do
+ * not exit shortly are killed. If a db snapshot file is given (see DbSnapshot), each
+ * worker materializes its db from it, otherwise it uses the copy of
+ * the db inherited from the coordinator. As with any fork of a
+ * multi-threaded process, the pool must be created while no other
+ * thread of the coordinator holds locks the workers need. In
+ * particular, creating it from Guile is unsafe, as other Guile
+ * threads, or a cogserver, may hold locks of the atomspace or of the
+ * logger when the workers are forked. Likewise the threads of
+ * matcher_pool() are not running in the workers, which thus mine
+ * with a single job, whatever param.jobs.
+ *
+ * Each worker is connected to the coordinator by a Unix domain
+ * socket, over which requests and responses are exchanged as lines
+ * of text, patterns being written as s-expressions, see
+ * MinerCheckpoint::encode_atom. The requests are
+ *
+ * mine <ATOMESE>
+ * support <MS> <ATOMESE>
+ *
+ * answered respectively by the specializations of the given pattern,
+ * in the order of the forest, so that parents precede their children
+ *
+ * pattern <PARENT> <SUPPORT> <ATOMESE>
+ *
+ * where PARENT is the index of the parent specialization, -1 for the
+ * shallow ones, and by the support of the given pattern up to MS
+ *
+ * support <SUPPORT>
+ *
+ * each response being terminated by a line
+ *
+ * done
+ *
+ * and a failed request by a line
+ *
+ * error <MESSAGE>
+ */
+class MinerWorkers
+{
+public:
+	/**
+	 * CTor, fork n_workers worker processes mining db with the given
+	 * parameters. Throw a RuntimeException if they cannot be forked,
+	 * after shutting down those already forked.
+	 *
+	 * Only the ALL output mode, without top-k, conjunction
+	 * expansion, score nor checkpoint, is supported.
+	 */
+	MinerWorkers(const MinerParameters& param, const HandleSeq& db,
+	             unsigned n_workers, const std::string& snapshot_file="");
+	~MinerWorkers();
+
+	MinerWorkers(const MinerWorkers&) = delete;
+	MinerWorkers& operator=(const MinerWorkers&) = delete;
+
+	/**
+	 * Mine the db like Miner::mine_forest. The shallow
+	 * specializations of param.initpat are mined by the coordinator,
+	 * then the subtree of specializations of each is mined by a
+	 * worker, and merged under it.
+	 */
+	PatternForest mine();
+
+	/**
+	 * Return the supports of the given patterns up to ms, each
+	 * calculated by a worker.
+	 */
+	std::vector<unsigned> supports(const HandleSeq& patterns, unsigned ms);
+
+	/**
+	 * Return the number of workers.
+	 */
+	unsigned size() const;
+
+private:
+	struct Worker
+	{
+		pid_t pid;
+		int fd;
+		// Received bytes not yet consumed as lines
+		std::string buffer;
+	};
+
+	/**
+	 * Close the sockets of the workers, wait for them to exit, and
+	 * terminate those that have not exited after shutdown_grace_ms.
+	 */
+	void shutdown();
+
+	// Time given to the workers to exit once their sockets are
+	// closed, and interval between checks, in milliseconds
+	static const unsigned shutdown_grace_ms = 1000;
+	static const unsigned shutdown_poll_ms = 10;
+
+	/**
+	 * Send each request to an idle worker, as soon as one is, and
+	 * return the lines of their responses, in the order of the
+	 * requests, without their terminating done lines. Throw a
+	 * RuntimeException if a worker fails or answers an error, after
+	 * shutting down the pool, busy workers included, so that no
+	 * response is left unread, or if the pool is already shut down.
+	 */
+	std::vector<std::vector<std::string>> dispatch(const std::vector<std::string>& requests);
+
+	/**
+	 * Serve the requests received over fd until it is closed, in the
+	 * worker process.
+	 */
+	void serve(int fd, const HandleSeq& db) const;
+
+	/**
+	 * Answer a single request, in the worker process.
+	 */
+	std::string answer(const std::string& request, const HandleSeq& db) const;
+
+	/**
+	 * Write a line to fd, followed by a new line. Return false on
+	 * failure.
+	 */
+	static bool write_line(int fd, const std::string& line);
+
+	/**
+	 * Read a line from fd, without its new line, buffer holding the
+	 * bytes already received but not consumed. Return false if fd is
+	 * closed or on failure.
+	 */
+	static bool read_line(int fd, std::string& buffer, std::string& line);
+
+	MinerParameters _param;
+	HandleSeq _db;
+	std::vector<Worker> _workers;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_MINER_WORKERS_H_ */
@@ -0,0 +1,202 @@
+/*
+ * PatternForest.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "PatternForest.h"
+
+#include <opencog/util/dorepeat.h>
+#include <opencog/util/oc_assert.h>
+
+#include <sstream>
+
+namespace opencog
+{
+
+PatternForest::PatternForest()
+	: _first_root(npos), _last_root(npos) {}
+
+unsigned PatternForest::add(const Handle& pattern, unsigned support,
+                            unsigned parent)
+{
+	OC_ASSERT(parent == npos or parent < size());
+	unsigned i = size();
+	_patterns.push_back(pattern);
+	_supports.push_back(support);
+	_parents.push_back(npos);
+	_first_children.push_back(npos);
+	_last_children.push_back(npos);
+	_next_siblings.push_back(npos);
+	link(i, parent);
+	return i;
+}
+
+void PatternForest::merge(PatternForest&& other, unsigned parent)
+{
+	OC_ASSERT(parent == npos or parent < size());
+	if (other.empty())
+		return;
+
+	// Offset all indices of other, except npos
+	unsigned offset = size();
+	auto shift = [&](unsigned i) { return i == npos ? npos : i + offset; };
+	auto move_in = [&](std::vector<unsigned>& dst, std::vector<unsigned>& src) {
+		dst.reserve(dst.size() + src.size());
+		for (unsigned i : src)
+			dst.push_back(shift(i));
+	};
+	_patterns.insert(_patterns.end(),
+	                 std::make_move_iterator(other._patterns.begin()),
+	                 std::make_move_iterator(other._patterns.end()));
+	_supports.insert(_supports.end(), other._supports.begin(),
+	                 other._supports.end());
+	move_in(_parents, other._parents);
+	move_in(_first_children, other._first_children);
+	move_in(_last_children, other._last_children);
+	move_in(_next_siblings, other._next_siblings);
+
+	// Attach the roots of other, their next siblings links are
+	// overwritten by link, so must be collected beforehand
+	std::vector<unsigned> roots;
+	for (unsigned r = other._first_root; r != npos; r = other._next_siblings[r])
+		roots.push_back(r + offset);
+	for (unsigned r : roots) {
+		_next_siblings[r] = npos;
+		link(r, parent);
+	}
+
+	other = PatternForest();
+}
+
+PatternForest PatternForest::filter_support(unsigned ms) const
+{
+	// Parents always precede their children, thus a single pass
+	// suffices, mapping each kept node to its new index
+	PatternForest filtered;
+	std::vector<unsigned> indices(size(), npos);
+	for (unsigned i = 0; i < size(); i++) {
+		unsigned p = _parents[i];
+		if (_supports[i] < ms or (p != npos and indices[p] == npos))
+			continue;
+		indices[i] = filtered.add(_patterns[i], _supports[i],
+		                          p == npos ? npos : indices[p]);
+	}
+	return filtered;
+}
+
+const Handle& PatternForest::pattern(unsigned i) const
+{
+	return _patterns[i];
+}
+
+unsigned PatternForest::support(unsigned i) const
+{
+	return _supports[i];
+}
+
+unsigned PatternForest::parent(unsigned i) const
+{
+	return _parents[i];
+}
+
+unsigned PatternForest::first_child(unsigned i) const
+{
+	return _first_children[i];
+}
+
+unsigned PatternForest::next_sibling(unsigned i) const
+{
+	return _next_siblings[i];
+}
+
+unsigned PatternForest::first_root() const
+{
+	return _first_root;
+}
+
+unsigned PatternForest::depth(unsigned i) const
+{
+	unsigned d = 0;
+	for (unsigned p = _parents[i]; p != npos; p = _parents[p])
+		d++;
+	return d;
+}
+
+unsigned PatternForest::size() const
+{
+	return _patterns.size();
+}
+
+bool PatternForest::empty() const
+{
+	return _patterns.empty();
+}
+
+HandleTree PatternForest::to_handle_tree() const
+{
+	HandleTree ht;
+	for (unsigned r = _first_root; r != npos; r = _next_siblings[r])
+		insert_subtree(ht, ht.end(), r);
+	return ht;
+}
+
+std::string PatternForest::to_string(const std::string& indent) const
+{
+	std::stringstream ss;
+	ss << indent << "size = " << size();
+	for (unsigned i = 0; i < size(); i++) {
+		std::string node_indent = indent;
+		dorepeat(depth(i))
+			node_indent += OC_TO_STRING_INDENT;
+		ss << std::endl << node_indent
+		   << "pattern[" << i << ",parent=" << (int)_parents[i]
+		   << ",support=" << _supports[i] << "]:" << std::endl
+		   << oc_to_string(_patterns[i], node_indent + OC_TO_STRING_INDENT);
+	}
+	return ss.str();
+}
+
+void PatternForest::link(unsigned i, unsigned parent)
+{
+	_parents[i] = parent;
+	unsigned& first = parent == npos ? _first_root : _first_children[parent];
+	unsigned& last = parent == npos ? _last_root : _last_children[parent];
+	if (last == npos)
+		first = i;
+	else
+		_next_siblings[last] = i;
+	last = i;
+}
+
+void PatternForest::insert_subtree(HandleTree& ht, HandleTree::iterator it,
+                                   unsigned i) const
+{
+	HandleTree::iterator cit = it == ht.end() ?
+		ht.insert(ht.end(), _patterns[i]) :
+		ht.append_child(it, _patterns[i]);
+	for (unsigned c = _first_children[i]; c != npos; c = _next_siblings[c])
+		insert_subtree(ht, cit, c);
+}
+
+std::string oc_to_string(const PatternForest& forest, const std::string& indent)
+{
+	return forest.to_string(indent);
+}
+
+} // namespace opencog
@@ -0,0 +1,144 @@
+/*
+ * PatternForest.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENCOG_PATTERN_FOREST_H_
+#define OPENCOG_PATTERN_FOREST_H_
+
+#include <vector>
+
+#include <opencog/util/empty_string.h>
+#include <opencog/atoms/base/Handle.h>
+
+#include "HandleTree.h"
+
+namespace opencog
+{
+
+/**
+ * Forest of patterns linked by specialization relationship (children
+ * are specializations of their parent), with their supports.
+ *
+ * Unlike HandleTree, nodes are not individually allocated but stored
+ * in contiguous arrays and linked by indices (parent, first child,
+ * last child and next sibling), so that adding a pattern is amortized
+ * constant time and merging a forest into another moves its arrays
+ * in rather than copying subtrees.
+ */
+class PatternForest
+{
+public:
+	/**
+	 * Index of no node
+	 */
+	static const unsigned npos = -1;
+
+	/**
+	 * CTor, empty forest.
+	 */
+	PatternForest();
+
+	/**
+	 * Add a pattern with its support as last child of parent, or as
+	 * last root if parent is npos. Return its index.
+	 */
+	unsigned add(const Handle& pattern, unsigned support,
+	             unsigned parent=npos);
+
+	/**
+	 * Move all nodes of other into this forest, the roots of other
+	 * becoming the last children of parent, or the last roots if
+	 * parent is npos. other is left empty.
+	 */
+	void merge(PatternForest&& other, unsigned parent=npos);
+
+	/**
+	 * Return a copy of the forest without the nodes of support below
+	 * ms, nor their descendants.
+	 */
+	PatternForest filter_support(unsigned ms) const;
+
+	/**
+	 * Return the pattern, support, parent, first child and next
+	 * sibling of node i.
+	 */
+	const Handle& pattern(unsigned i) const;
+	unsigned support(unsigned i) const;
+	unsigned parent(unsigned i) const;
+	unsigned first_child(unsigned i) const;
+	unsigned next_sibling(unsigned i) const;
+
+	/**
+	 * Return the index of the first root, npos if empty.
+	 */
+	unsigned first_root() const;
+
+	/**
+	 * Return the depth of node i, 0 for roots.
+	 */
+	unsigned depth(unsigned i) const;
+
+	/**
+	 * Return the number of nodes.
+	 */
+	unsigned size() const;
+
+	/**
+	 * Return true iff the forest has no node.
+	 */
+	bool empty() const;
+
+	/**
+	 * Convert into a HandleTree (with the same sibling order).
+	 */
+	HandleTree to_handle_tree() const;
+
+	std::string to_string(const std::string& indent=empty_string) const;
+
+private:
+	/**
+	 * Append node i as last child of parent, or as last root if
+	 * parent is npos.
+	 */
+	void link(unsigned i, unsigned parent);
+
+	/**
+	 * Insert the subtree rooted at i as last child of it in ht, or as
+	 * last root if it is ht.end().
+	 */
+	void insert_subtree(HandleTree& ht, HandleTree::iterator it,
+	                    unsigned i) const;
+
+	HandleSeq _patterns;
+	std::vector<unsigned> _supports;
+	std::vector<unsigned> _parents;
+	std::vector<unsigned> _first_children;
+	std::vector<unsigned> _last_children;
+	std::vector<unsigned> _next_siblings;
+	unsigned _first_root;
+	unsigned _last_root;
+};
+
+std::string oc_to_string(const PatternForest& forest,
+                         const std::string& indent=empty_string);
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_PATTERN_FOREST_H_ */
@@ -0,0 +1,166 @@
+/*
+ * PatternLattice.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "PatternLattice.h"
+#include "MinerUtils.h"
+
+#include <opencog/util/oc_assert.h>
+
+#include <boost/range/algorithm/find.hpp>
+
+#include <sstream>
+
+namespace opencog
+{
+
+PatternLattice::PatternLattice() : _edges_count(0) {}
+
+unsigned PatternLattice::add(const Handle& pattern, unsigned support,
+                             unsigned parent)
+{
+	OC_ASSERT(parent == npos or parent < size());
+	unsigned i = find(pattern);
+	if (i == npos) {
+		i = size();
+		_nodes.push_back({pattern, support, {}, {}});
+		_index.insert({pattern->get_hash(), i});
+	}
+	const std::vector<unsigned>& parents = _nodes[i].parents;
+	if (parent != npos and boost::find(parents, parent) == parents.end()) {
+		_nodes[i].parents.push_back(parent);
+		_nodes[parent].children.push_back(i);
+		_edges_count++;
+	}
+	return i;
+}
+
+PatternLattice PatternLattice::filter_support(unsigned ms) const
+{
+	// Specializations never have a higher support than the patterns
+	// they are obtained from, thus the kept nodes are closed under
+	// parents. Add them first, then their edges, as a node may get a
+	// parent added after it.
+	PatternLattice filtered;
+	std::vector<unsigned> indices(size(), npos);
+	for (unsigned i = 0; i < size(); i++)
+		if (ms <= _nodes[i].support)
+			indices[i] = filtered.add(_nodes[i].pattern, _nodes[i].support);
+	for (unsigned i = 0; i < size(); i++) {
+		if (indices[i] == npos)
+			continue;
+		for (unsigned c : _nodes[i].children)
+			if (indices[c] != npos)
+				filtered.add(_nodes[c].pattern, _nodes[c].support, indices[i]);
+	}
+	return filtered;
+}
+
+unsigned PatternLattice::find(const Handle& pattern) const
+{
+	auto range = _index.equal_range(pattern->get_hash());
+	for (auto it = range.first; it != range.second; ++it)
+		if (content_eq(_nodes[it->second].pattern, pattern))
+			return it->second;
+	return npos;
+}
+
+const Handle& PatternLattice::pattern(unsigned i) const
+{
+	return _nodes[i].pattern;
+}
+
+unsigned PatternLattice::support(unsigned i) const
+{
+	return _nodes[i].support;
+}
+
+const std::vector<unsigned>& PatternLattice::parents(unsigned i) const
+{
+	return _nodes[i].parents;
+}
+
+const std::vector<unsigned>& PatternLattice::children(unsigned i) const
+{
+	return _nodes[i].children;
+}
+
+HandleSeq PatternLattice::patterns() const
+{
+	HandleSeq pats;
+	for (const Node& node : _nodes)
+		pats.push_back(node.pattern);
+	return pats;
+}
+
+unsigned PatternLattice::size() const
+{
+	return _nodes.size();
+}
+
+unsigned PatternLattice::edges_count() const
+{
+	return _edges_count;
+}
+
+bool PatternLattice::empty() const
+{
+	return _nodes.empty();
+}
+
+Handle PatternLattice::to_atomese(AtomSpace& as) const
+{
+	HandleSeq pats, members;
+	for (const Node& node : _nodes) {
+		Handle pat = as.add_atom(node.pattern);
+		MinerUtils::set_support(pat, node.support);
+		pats.push_back(pat);
+	}
+	for (unsigned i = 0; i < size(); i++) {
+		for (unsigned c : _nodes[i].children)
+			members.push_back(as.add_link(INHERITANCE_LINK, pats[c], pats[i]));
+		if (_nodes[i].parents.empty() and _nodes[i].children.empty())
+			members.push_back(pats[i]);
+	}
+	return as.add_link(SET_LINK, std::move(members));
+}
+
+std::string PatternLattice::to_string(const std::string& indent) const
+{
+	std::stringstream ss;
+	ss << indent << "size = " << size()
+	   << ", edges_count = " << edges_count();
+	for (unsigned i = 0; i < size(); i++) {
+		ss << std::endl << indent << "pattern[" << i
+		   << ",support=" << _nodes[i].support << ",parents={";
+		for (unsigned j = 0; j < _nodes[i].parents.size(); j++)
+			ss << (j == 0 ? "" : ",") << _nodes[i].parents[j];
+		ss << "}]:" << std::endl
+		   << oc_to_string(_nodes[i].pattern, indent + OC_TO_STRING_INDENT);
+	}
+	return ss.str();
+}
+
+std::string oc_to_string(const PatternLattice& lattice, const std::string& indent)
+{
+	return lattice.to_string(indent);
+}
+
+} // namespace opencog
@@ -0,0 +1,137 @@
+/*
+ * PatternLattice.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef OPENCOG_PATTERN_LATTICE_H_
+#define OPENCOG_PATTERN_LATTICE_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <opencog/util/empty_string.h>
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/atomspace/AtomSpace.h>
+
+namespace opencog
+{
+
+/**
+ * Lattice of patterns linked by specialization relationship, with
+ * their supports. Unlike HandleTree or PatternForest, a pattern
+ * reachable from several more abstract patterns is stored only once
+ * (up to alpha-equivalence), with one edge per parent.
+ */
+class PatternLattice
+{
+public:
+	/**
+	 * Index of no node
+	 */
+	static const unsigned npos = -1;
+
+	/**
+	 * CTor, empty lattice.
+	 */
+	PatternLattice();
+
+	/**
+	 * Add a pattern with its support as a specialization of parent,
+	 * or without parent if npos. If the pattern is already present
+	 * only the edge is added (if not already there). Return its
+	 * index.
+	 */
+	unsigned add(const Handle& pattern, unsigned support,
+	             unsigned parent=npos);
+
+	/**
+	 * Return a copy of the lattice without the nodes of support below
+	 * ms, nor their edges.
+	 */
+	PatternLattice filter_support(unsigned ms) const;
+
+	/**
+	 * Return the index of pattern (up to alpha-equivalence), npos if
+	 * absent.
+	 */
+	unsigned find(const Handle& pattern) const;
+
+	/**
+	 * Return the pattern, support, parents (more abstract patterns)
+	 * and children (specializations) of node i.
+	 */
+	const Handle& pattern(unsigned i) const;
+	unsigned support(unsigned i) const;
+	const std::vector<unsigned>& parents(unsigned i) const;
+	const std::vector<unsigned>& children(unsigned i) const;
+
+	/**
+	 * Return all patterns, in order of insertion.
+	 */
+	HandleSeq patterns() const;
+
+	/**
+	 * Return the number of nodes, and the number of edges.
+	 */
+	unsigned size() const;
+	unsigned edges_count() const;
+
+	/**
+	 * Return true iff the lattice has no node.
+	 */
+	bool empty() const;
+
+	/**
+	 * Add the lattice to the given atomspace. Each pattern gets its
+	 * support memoized (see MinerUtils::set_support) and each edge is
+	 * represented by
+	 *
+	 * (Inheritance specialization pattern)
+	 *
+	 * all wrapped in a SetLink, which is returned. Patterns without
+	 * parent nor child are directly members of that SetLink.
+	 */
+	Handle to_atomese(AtomSpace& as) const;
+
+	std::string to_string(const std::string& indent=empty_string) const;
+
+private:
+	struct Node
+	{
+		Handle pattern;
+		unsigned support;
+		std::vector<unsigned> parents;
+		std::vector<unsigned> children;
+	};
+
+	std::vector<Node> _nodes;
+
+	// Index from content hash (invariant under alpha-conversion) to
+	// nodes
+	std::unordered_multimap<ContentHash, unsigned> _index;
+
+	unsigned _edges_count;
+};
+
+std::string oc_to_string(const PatternLattice& lattice,
+                         const std::string& indent=empty_string);
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_PATTERN_LATTICE_H_ */
@@ -25,6 +25,7 @@
 
 #include "MinerUtils.h"
 #include "MinerLogger.h"
+#include "MinerCache.h"
 
 #include <opencog/util/Logger.h>
 #include <opencog/util/lazy_random_selector.h>
@@ -45,10 +46,16 @@
 #include <boost/range/algorithm/sort.hpp>
 #include <boost/range/numeric.hpp>
 #include <boost/math/special_functions/binomial.hpp>
+#include <boost/math/special_functions/beta.hpp>
 
+#include <algorithm>
 #include <cmath>
 #include <functional>
 #include <limits>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <tuple>
 
 namespace opencog {
 
@@ -100,16 +107,157 @@ double Surprisingness::isurp(const Handle& pattern,
 	// into account the linkage probability.
 	auto [emin, emax] = ji_prob_est_interval(pattern, db, db_ratio);
 
+	return isurp_from_interval(pattern, db, emin, emax, normalize, db_ratio);
+}
+
+double Surprisingness::isurp_from_interval(const Handle& pattern,
+                                           const HandleSeq& db,
+                                           double emin,
+                                           double emax,
+                                           bool normalize,
+                                           double db_ratio)
+{
 	// Calculate the empirical probability of pattern, using
 	// boostrapping if necessary
 	double emp = emp_prob_pbs_mem(pattern, db, emax, db_ratio);
 
 	// Calculate the I-Surprisingness, normalized if requested.
+	return isurp_from_probs(emin, emax, emp, normalize);
+}
+
+double Surprisingness::isurp_from_probs(double emin, double emax, double emp,
+                                        bool normalize)
+{
 	double dst = dst_from_interval(emin, emax, emp);
 	double maxprb = std::max(emp, emax);
+	if (normalize and maxprb <= 0.0)
+		return 0.0;
 	return std::min(normalize ? dst / maxprb : dst, 1.0);
 }
 
+double Surprisingness::isurp_upper_bound(const Handle& pattern,
+                                         const HandleSeq& db,
+                                         double emin,
+                                         double emax,
+                                         bool normalize,
+                                         double db_ratio)
+{
+	double lemp = emp_prob_lower_bound(pattern, db);
+	double uemp = std::max(lemp, emp_prob_upper_bound(pattern, db, db_ratio));
+	return std::max(isurp_from_probs(emin, emax, lemp, normalize),
+	                isurp_from_probs(emin, emax, uemp, normalize));
+}
+
+Surprisingness::HandleDoubleSeq Surprisingness::isurp_top_k(const HandleSeq& patterns,
+                                                            const HandleSeq& db,
+                                                            unsigned k,
+                                                            bool normalize,
+                                                            double db_ratio)
+{
+	if (k == 0)
+		return {};
+
+	// Calculate the probability estimate interval of each pattern
+	// and derive an upper bound of its surprisingness from it.
+	struct Candidate {
+		Handle pattern;
+		double emin;
+		double emax;
+		double upper;
+	};
+	std::vector<Candidate> candidates;
+	unsigned n_subsampled = 0;
+	for (const Handle& pattern : patterns) {
+		if (MinerUtils::n_conjuncts(pattern) < 2)
+			continue;
+		auto [emin, emax] = ji_prob_est_interval(pattern, db, db_ratio);
+		// The empirical probability of a subsampled pattern is an
+		// estimate that its bounds do not hold for, thus it is never
+		// pruned.
+		bool subsampled = is_subsampled(pattern, db, emax, db_ratio);
+		double upper = subsampled ? std::numeric_limits<double>::infinity()
+			: isurp_upper_bound(pattern, db, emin, emax, normalize, db_ratio);
+		n_subsampled += subsampled;
+		candidates.push_back({pattern, emin, emax, upper});
+	}
+	if (0 < n_subsampled)
+		LAZY_MINER_LOG_DEBUG << n_subsampled << " out of " << candidates.size()
+		                     << " patterns are subsampled and cannot be pruned";
+
+	// Visit the candidates by decreasing upper bound
+	boost::sort(candidates, [](const Candidate& l, const Candidate& r) {
+			return l.upper > r.upper; });
+
+	// Maintain the top k found so far as a min-heap, so that its
+	// front is the k-th best surprisingness.
+	auto greater_surp = [](const HandleDouble& l, const HandleDouble& r) {
+		return l.second > r.second; };
+	HandleDoubleSeq top;
+	unsigned n_evaluated = 0;
+	for (const Candidate& cdt : candidates) {
+		// No remaining candidate can beat the k-th best
+		if (top.size() == k and cdt.upper <= top.front().second)
+			break;
+
+		double surp = isurp_from_interval(cdt.pattern, db, cdt.emin, cdt.emax,
+		                                  normalize, db_ratio);
+		n_evaluated++;
+		if (top.size() < k) {
+			top.emplace_back(cdt.pattern, surp);
+			std::push_heap(top.begin(), top.end(), greater_surp);
+		} else if (top.front().second < surp) {
+			std::pop_heap(top.begin(), top.end(), greater_surp);
+			top.back() = {cdt.pattern, surp};
+			std::push_heap(top.begin(), top.end(), greater_surp);
+		}
+	}
+	LAZY_MINER_LOG_DEBUG << "Calculated the empirical probability of "
+	                     << n_evaluated << " out of " << candidates.size()
+	                     << " patterns to obtain the top " << k;
+
+	// Sort by decreasing surprisingness
+	std::sort_heap(top.begin(), top.end(), greater_surp);
+	return top;
+}
+
+Surprisingness::HandleDoubleSeq Surprisingness::surp_top_k(const std::string& mode,
+                                                           const HandleSeq& patterns,
+                                                           const HandleSeq& db,
+                                                           unsigned k,
+                                                           double db_ratio)
+{
+	if (mode == "isurp" or mode == "nisurp")
+		return isurp_top_k(patterns, db, k, mode == "nisurp", db_ratio);
+
+	bool old = mode == "isurp-old" or mode == "nisurp-old";
+	if (not old and mode != "jsdsurp")
+		throw RuntimeException(TRACE_INFO,
+		                       "Unknown surprisingness mode %s", mode.c_str());
+
+	HandleDoubleSeq surps;
+	for (const Handle& pattern : patterns) {
+		if (MinerUtils::n_conjuncts(pattern) < 2)
+			continue;
+		if (old) {
+			surps.emplace_back(pattern,
+			                   isurp_old(pattern, db, mode == "nisurp-old"));
+		} else {
+			// Like the emp, est, jsd and jsd-surprisingness rules
+			TruthValuePtr jte = ji_tv_est_mem(pattern, db);
+			TruthValuePtr etv = emp_tv_pbs_mem(pattern, db, jte->get_mean(),
+			                                   db_ratio);
+			surps.emplace_back(pattern, jsd(etv, jte));
+		}
+	}
+
+	// Sort by decreasing surprisingness and keep the top k
+	boost::sort(surps, [](const HandleDouble& l, const HandleDouble& r) {
+			return l.second > r.second; });
+	if (k < surps.size())
+		surps.resize(k);
+	return surps;
+}
+
 double Surprisingness::dst_from_interval(double l, double u, double v)
 {
 	return (u < v ? v - u : (v < l ? l - v : 0.0));
@@ -195,6 +343,13 @@ double Surprisingness::universe_count(const Handle& pattern,
 	return std::pow((double)db.size(), MinerUtils::n_conjuncts(pattern));
 }
 
+double Surprisingness::universe_count(const Handle& pattern,
+                                      const HandleUCounter& wdb)
+{
+	return std::pow((double)MinerUtils::db_size(wdb),
+	                MinerUtils::n_conjuncts(pattern));
+}
+
 double Surprisingness::prob_to_support(const Handle& pattern,
                                        const HandleSeq& db,
                                        double prob)
@@ -212,12 +367,12 @@ double Surprisingness::emp_prob(const Handle& pattern, const HandleSeq& db)
 
 double Surprisingness::emp_prob_mem(const Handle& pattern, const HandleSeq& db)
 {
-	TruthValuePtr emp_prob_tv = get_emp_tv(pattern);
+	TruthValuePtr emp_prob_tv = get_emp_tv(pattern, db);
 	if (emp_prob_tv) {
 		return emp_prob_tv->get_mean();
 	}
 	double ep = emp_prob(pattern, db);
-	set_emp_prob(pattern, ep);
+	set_emp_prob(pattern, db, ep);
 	return ep;
 }
 
@@ -246,12 +401,12 @@ TruthValuePtr Surprisingness::emp_tv(const Handle& pattern, const HandleSeq& db)
 TruthValuePtr Surprisingness::emp_tv_mem(const Handle& pattern,
                                          const HandleSeq& db)
 {
-	TruthValuePtr etv = get_emp_tv(pattern);
+	TruthValuePtr etv = get_emp_tv(pattern, db);
 	if (etv) {
 		return etv;
 	}
 	etv = emp_tv(pattern, db);
-	set_emp_tv(pattern, etv);
+	set_emp_tv(pattern, db, etv);
 	return etv;
 }
 
@@ -294,6 +449,17 @@ double Surprisingness::emp_prob_pbs(const Handle& pattern,
 	}
 }
 
+bool Surprisingness::is_subsampled(const Handle& pattern,
+                                   const HandleSeq& db,
+                                   double prob_estimate,
+                                   double db_ratio)
+{
+	// Same test as emp_prob_pbs, which emp_prob_pbs_mem only calls
+	// if the empirical probability is not memoized
+	return not get_emp_tv(pattern, db)
+		and db.size() * db_ratio < prob_to_support(pattern, db, prob_estimate);
+}
+
 double Surprisingness::emp_prob_pbs(const Handle& pattern,
                                     const HandleSeq& db,
                                     double prob_estimate,
@@ -340,12 +506,12 @@ double Surprisingness::emp_prob_pbs_mem(const Handle& pattern,
                                         const HandleSeq& db,
                                         double db_ratio)
 {
-	TruthValuePtr etv = get_emp_tv(pattern);
+	TruthValuePtr etv = get_emp_tv(pattern, db);
 	if (etv) {
 		return etv->get_mean();
 	}
 	double ep = emp_prob_pbs(pattern, db, db_ratio);
-	set_emp_prob(pattern, ep);
+	set_emp_prob(pattern, db, ep);
 	return ep;
 }
 
@@ -354,15 +520,48 @@ double Surprisingness::emp_prob_pbs_mem(const Handle& pattern,
                                         double prob_estimate,
                                         double db_ratio)
 {
-	TruthValuePtr etv = get_emp_tv(pattern);
+	TruthValuePtr etv = get_emp_tv(pattern, db);
 	if (etv) {
 		return etv->get_mean();
 	}
 	double ep = emp_prob_pbs(pattern, db, prob_estimate, db_ratio);
-	set_emp_prob(pattern, ep);
+	set_emp_prob(pattern, db, ep);
 	return ep;
 }
 
+double Surprisingness::emp_prob_lower_bound(const Handle& pattern,
+                                            const HandleSeq& db)
+{
+	TruthValuePtr etv = get_emp_tv(pattern, db);
+	if (etv)
+		return etv->get_mean();
+	double sup;
+	if (MinerUtils::get_support(pattern, db, 0, sup) and 0.0 < sup)
+		return sup / universe_count(pattern, db);
+	return 0.0;
+}
+
+double Surprisingness::emp_prob_upper_bound(const Handle& pattern,
+                                            const HandleSeq& db,
+                                            double db_ratio)
+{
+	TruthValuePtr etv = get_emp_tv(pattern, db);
+	if (etv)
+		return etv->get_mean();
+
+	double upper = 1.0;
+	HandleSeqSeqSeq prtns = MinerUtils::partitions_without_pattern(pattern);
+	for (const HandleSeqSeq& partition : prtns) {
+		HandleSeq subpatterns = add_subpatterns(partition, pattern,
+		                                        *pattern->getAtomSpace());
+		double p = 1.0;
+		for (const Handle& subpattern : subpatterns)
+			p *= emp_prob_pbs_mem(subpattern, db, db_ratio);
+		upper = std::min(upper, p);
+	}
+	return upper;
+}
+
 TruthValuePtr Surprisingness::emp_tv_bs(const Handle& pattern,
                                         const HandleSeq& db,
                                         unsigned n_resample,
@@ -408,12 +607,12 @@ TruthValuePtr Surprisingness::emp_tv_pbs_mem(const Handle& pattern,
                                              double prob_estimate,
                                              double db_ratio)
 {
-	TruthValuePtr etv = get_emp_tv(pattern);
+	TruthValuePtr etv = get_emp_tv(pattern, db);
 	if (etv) {
 		return etv;
 	}
 	etv = emp_tv_pbs(pattern, db, prob_estimate, db_ratio);
-	set_emp_tv(pattern, etv);
+	set_emp_tv(pattern, db, etv);
 	return etv;
 }
 
@@ -551,12 +750,12 @@ TruthValuePtr Surprisingness::ji_tv_est(const Handle& pattern,
 TruthValuePtr Surprisingness::ji_tv_est_mem(const Handle& pattern,
                                             const HandleSeq& db)
 {
-	TruthValuePtr jte = get_ji_tv_est(pattern);
+	TruthValuePtr jte = get_ji_tv_est(pattern, db);
 	if (jte) {
 		return jte;
 	}
 	jte = ji_tv_est(pattern, db);
-	set_ji_tv_est(pattern, jte);
+	set_ji_tv_est(pattern, db, jte);
 	return jte;
 }
 
@@ -656,23 +855,27 @@ const Handle& Surprisingness::emp_tv_key()
 	return etvk;
 }
 
-TruthValuePtr Surprisingness::get_emp_tv(const Handle& pattern)
+TruthValuePtr Surprisingness::get_emp_tv(const Handle& pattern,
+                                         const HandleSeq& db)
 {
 	ValuePtr val = pattern->getValue(emp_tv_key());
 	if (val)
 		return TruthValueCast(val);
-	return nullptr;
+	return miner_cache().get_emp_tv(pattern, db);
 }
 
-void Surprisingness::set_emp_tv(const Handle& pattern, TruthValuePtr etv)
+void Surprisingness::set_emp_tv(const Handle& pattern, const HandleSeq& db,
+                                TruthValuePtr etv)
 {
-	pattern->setValue(emp_tv_key(), ValueCast(etv));
+	if (not miner_cache().set_emp_tv(pattern, db, etv))
+		pattern->setValue(emp_tv_key(), ValueCast(etv));
 }
 
-void Surprisingness::set_emp_prob(const Handle& pattern, double ep)
+void Surprisingness::set_emp_prob(const Handle& pattern, const HandleSeq& db,
+                                  double ep)
 {
 	TruthValuePtr etv = createSimpleTruthValue(ep, 1.0);
-	set_emp_tv(pattern, etv);
+	set_emp_tv(pattern, db, etv);
 }
 
 const Handle& Surprisingness::ji_tv_est_key()
@@ -681,40 +884,150 @@ const Handle& Surprisingness::ji_tv_est_key()
 	return jtek;
 }
 
-TruthValuePtr Surprisingness::get_ji_tv_est(const Handle& pattern)
+TruthValuePtr Surprisingness::get_ji_tv_est(const Handle& pattern,
+                                            const HandleSeq& db)
 {
 	ValuePtr val = pattern->getValue(ji_tv_est_key());
 	if (val)
 		return TruthValueCast(val);
-	return nullptr;
+	return miner_cache().get_ji_tv_est(pattern, db);
 }
 
-void Surprisingness::set_ji_tv_est(const Handle& pattern, TruthValuePtr jte)
+void Surprisingness::set_ji_tv_est(const Handle& pattern, const HandleSeq& db,
+                                   TruthValuePtr jte)
 {
-	pattern->setValue(ji_tv_est_key(), ValueCast(jte));
+	if (not miner_cache().set_ji_tv_est(pattern, db, jte))
+		pattern->setValue(ji_tv_est_key(), ValueCast(jte));
 }
 
 double Surprisingness::jsd(TruthValuePtr l_tv, TruthValuePtr r_tv)
 {
-	static int bins = 100;
-	BetaDistribution l_bd(l_tv);
-	BetaDistribution r_bd(r_tv);
-	std::vector<double>
-		l_cdf = l_bd.cdf(bins),
-		r_cdf = r_bd.cdf(bins),
-		m_cdf = avrg_cdf(l_cdf, r_cdf);
-	double
-		ld = kld(l_cdf, m_cdf),
-		rd = kld(r_cdf, m_cdf);
+	return jsd(l_tv, r_tv, jsd_bins());
+}
 
+double Surprisingness::jsd(TruthValuePtr l_tv, TruthValuePtr r_tv,
+                           unsigned bins)
+{
 	// logger().debug() << "CSV representation of the pdf of the left TV. ";
-	// log_pdf(l_bd, bins);
+	// log_pdf(BetaDistribution(l_tv), bins);
 	// logger().debug() << "CSV representation of the pdf of the right TV. ";
-	// log_pdf(r_bd, bins);
+	// log_pdf(BetaDistribution(r_tv), bins);
+
+	return jsd(*beta_cdf(l_tv, bins), *beta_cdf(r_tv, bins));
+}
+
+double Surprisingness::jsd(const std::vector<double>& l_cdf,
+                           const std::vector<double>& r_cdf)
+{
+	static double epsilon = 1e-32;
+	OC_ASSERT(l_cdf.size() == r_cdf.size());
 
+	// Calculate the probabilities of each bin of both cdfs
+	size_t bins = l_cdf.size();
+	std::vector<double> l_p(bins), r_p(bins);
+	std::adjacent_difference(l_cdf.begin(), l_cdf.end(), l_p.begin());
+	std::adjacent_difference(r_cdf.begin(), r_cdf.end(), r_p.begin());
+
+	// Integrate the relative entropies of both cdfs relative to their
+	// average, like kld(l_cdf, m_cdf) and kld(r_cdf, m_cdf) would.
+	double ld = 0.0, rd = 0.0;
+	for (size_t i = 0; i < bins; i++) {
+		double lp = l_p[i], rp = r_p[i];
+		if (lp <= epsilon and rp <= epsilon)
+			continue;
+		double mp = avrg(lp, rp);
+		if (epsilon < mp) {
+			if (epsilon < lp)
+				ld += lp * std::log2(lp / mp);
+			if (epsilon < rp)
+				rd += rp * std::log2(rp / mp);
+		}
+	}
 	return sqrt(avrg(ld, rd));
 }
 
+namespace {
+unsigned default_jsd_bins = 100;
+}
+
+unsigned Surprisingness::jsd_bins()
+{
+	return default_jsd_bins;
+}
+
+void Surprisingness::set_jsd_bins(unsigned bins)
+{
+	OC_ASSERT(0 < bins);
+	default_jsd_bins = bins;
+}
+
+std::shared_ptr<const std::vector<double>> Surprisingness::beta_cdf(TruthValuePtr tv,
+                                                                    unsigned bins)
+{
+	typedef std::tuple<double, double, unsigned> CdfKey;
+	typedef std::shared_ptr<const std::vector<double>> CdfPtr;
+	static std::map<CdfKey, CdfPtr> cache;
+	static std::mutex cache_mtx;
+	// Beyond that size the cache is merely flushed
+	static const size_t max_cache_size = 100000;
+
+	BetaDistribution bd(tv);
+	CdfKey key(bd.alpha(), bd.beta(), bins);
+	{
+		std::lock_guard<std::mutex> lock(cache_mtx);
+		auto it = cache.find(key);
+		if (it != cache.end())
+			return it->second;
+	}
+
+	// Calculate outside of the lock, at worse the same cdf is
+	// calculated twice by concurrent threads.
+	CdfPtr cdf = std::make_shared<const std::vector<double>>(
+		beta_cdf(bd.alpha(), bd.beta(), bins));
+
+	std::lock_guard<std::mutex> lock(cache_mtx);
+	if (max_cache_size <= cache.size())
+		cache.clear();
+	cache.emplace(key, cdf);
+	return cdf;
+}
+
+std::vector<double> Surprisingness::beta_cdf(double alpha, double beta,
+                                             unsigned bins)
+{
+	auto cdf_at = [&](unsigned i) {
+		return boost::math::ibeta(alpha, beta, (i + 1.0) / bins); };
+
+	// Find the first bin where the cdf is above 0
+	unsigned lo = 0, hi = bins;
+	while (lo < hi) {
+		unsigned mid = lo + (hi - lo) / 2;
+		if (0.0 < cdf_at(mid))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	unsigned first = lo;
+
+	// Find the first bin, after first, where the cdf reaches 1
+	lo = first; hi = bins;
+	while (lo < hi) {
+		unsigned mid = lo + (hi - lo) / 2;
+		if (cdf_at(mid) < 1.0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	unsigned last = lo;
+
+	// Only evaluate the cdf in between
+	std::vector<double> cdf(bins, 1.0);
+	std::fill(cdf.begin(), cdf.begin() + first, 0.0);
+	for (unsigned i = first; i < last; i++)
+		cdf[i] = cdf_at(i);
+	return cdf;
+}
+
 double Surprisingness::kld(const std::vector<double>& l_cdf,
                            const std::vector<double>& r_cdf)
 {
@@ -28,6 +28,8 @@
 #include <opencog/atomspace/AtomSpace.h>
 #include <opencog/ure/BetaDistribution.h>
 
+#include <memory>
+
 namespace opencog
 {
 
@@ -37,6 +39,12 @@ namespace opencog
 
 class Surprisingness {
 public:
+	/**
+	 * Pattern paired with its surprisingness.
+	 */
+	typedef std::pair<Handle, double> HandleDouble;
+	typedef std::vector<HandleDouble> HandleDoubleSeq;
+
 	// TODO: We could reframe isurp_old and isurp to use the same
 	// inference tree decomposition as in the JSD case, using standard
 	// deviation or such to determine the interval of the estimate.
@@ -337,6 +345,91 @@ public:
 	                    bool normalize=true,
 	                    double db_ratio=1.0);
 
+	/**
+	 * Like isurp but takes the probability estimate interval [emin,
+	 * emax] of the pattern, as calculated by ji_prob_est_interval,
+	 * instead of recalculating it.
+	 */
+	static double isurp_from_interval(const Handle& pattern,
+	                                  const HandleSeq& db,
+	                                  double emin,
+	                                  double emax,
+	                                  bool normalize=true,
+	                                  double db_ratio=1.0);
+
+	/**
+	 * Given the probability estimate interval [emin, emax] of a
+	 * pattern, and its empirical probability emp, return its
+	 * I-Surprisingness, normalized if requested.
+	 */
+	static double isurp_from_probs(double emin, double emax, double emp,
+	                               bool normalize);
+
+	/**
+	 * Return an upper bound of the I-Surprisingness of pattern given
+	 * its probability estimate interval [emin, emax], without
+	 * calculating its empirical probability.
+	 *
+	 * The empirical probability of the pattern is bounded by the
+	 * interval [emp_prob_lower_bound, emp_prob_upper_bound], and since
+	 * the I-Surprisingness, as a function of the empirical
+	 * probability, is decreasing then increasing, its maximum over
+	 * that interval is reached on one of its ends.
+	 */
+	static double isurp_upper_bound(const Handle& pattern,
+	                                const HandleSeq& db,
+	                                double emin,
+	                                double emax,
+	                                bool normalize=true,
+	                                double db_ratio=1.0);
+
+	/**
+	 * Return the k most I-Surprising patterns amongst the given
+	 * patterns, sorted by decreasing surprisingness.
+	 *
+	 * The probability estimate interval, which only involves the
+	 * subpatterns of a pattern, is calculated first for all patterns
+	 * to derive an upper bound of their surprisingness (see
+	 * isurp_upper_bound). Then patterns are visited by decreasing
+	 * upper bound, and their empirical probability, which is the
+	 * costly part, is only calculated as long as they can still enter
+	 * the top k.
+	 *
+	 * Patterns with less than 2 conjuncts are ignored since they
+	 * have no partition to estimate their probability from.
+	 *
+	 * Patterns whose empirical probability is estimated by
+	 * subsampling the db (see is_subsampled) are never pruned, as
+	 * that estimate may fall outside of their bounds. The
+	 * probabilities of blocks of several conjuncts may be estimated
+	 * by subsampling as well, their product is then only an
+	 * estimate of the upper bound, thus, like the surprisingness
+	 * itself, the top k is approximate when db_ratio is low enough
+	 * for blocks to be subsampled.
+	 */
+	static HandleDoubleSeq isurp_top_k(const HandleSeq& patterns,
+	                                   const HandleSeq& db,
+	                                   unsigned k,
+	                                   bool normalize=true,
+	                                   double db_ratio=1.0);
+
+	/**
+	 * Given a surprisingness mode, as named by cog-mine, that is
+	 * "isurp-old", "nisurp-old", "isurp", "nisurp" or "jsdsurp",
+	 * return the k most surprising patterns w.r.t. db (all by
+	 * default), sorted by decreasing surprisingness, as calculated by
+	 * the corresponding surprisingness rules, without the rule
+	 * engine. For "isurp" and "nisurp", see isurp_top_k.
+	 *
+	 * Patterns with less than 2 conjuncts are ignored, like by the
+	 * rules. Throw a RuntimeException if the mode is unknown.
+	 */
+	static HandleDoubleSeq surp_top_k(const std::string& mode,
+	                                  const HandleSeq& patterns,
+	                                  const HandleSeq& db,
+	                                  unsigned k=UINT_MAX,
+	                                  double db_ratio=1.0);
+
 	/**
 	 * Return the distance between a value and an interval
 	 *
@@ -433,6 +526,8 @@ public:
 	 * Calculate the universe count of the pattern over the given db
 	 */
 	static double universe_count(const Handle& pattern, const HandleSeq& db);
+	static double universe_count(const Handle& pattern,
+	                             const HandleUCounter& wdb);
 
 	/**
 	 * Given a pattern, a corpus and a probability, calculate the
@@ -493,6 +588,18 @@ public:
 	                           double prob_estimate,
 	                           double db_ratio);
 
+	/**
+	 * Return true if emp_prob_pbs_mem would estimate the empirical
+	 * probability of pattern by subsampling db, given its probability
+	 * estimate, rather than calculate it exactly. That is if it is
+	 * not memoized and its support estimate exceeds the rescaled db
+	 * size.
+	 */
+	static bool is_subsampled(const Handle& pattern,
+	                          const HandleSeq& db,
+	                          double prob_estimate,
+	                          double db_ratio=1.0);
+
 	/**
 	 * Like emp_prob_pbs with memoization.
 	 */
@@ -504,6 +611,35 @@ public:
 	                               double prob_estimate,
 	                               double db_ratio);
 
+	/**
+	 * Return a lower bound of the empirical probability of a pattern
+	 * without running the pattern matcher. That is its memoized
+	 * empirical probability if any, otherwise its memoized support
+	 * (which may have been calculated up to the minimum support only)
+	 * divided by the universe count, otherwise 0.
+	 */
+	static double emp_prob_lower_bound(const Handle& pattern,
+	                                   const HandleSeq& db);
+
+	/**
+	 * Return an upper bound of the empirical probability of a
+	 * pattern, that is its memoized empirical probability if any,
+	 * otherwise the minimum over all its partitions of the product of
+	 * the empirical probabilities of their blocks. Indeed each
+	 * grounding of the pattern is made of groundings of each block,
+	 * thus the pattern count cannot exceed the product of the block
+	 * counts.
+	 *
+	 * The block probabilities are memoized and are the same as the
+	 * ones used by ji_prob_est, so calculating that bound after
+	 * ji_prob_est_interval comes almost for free. Since blocks may be
+	 * subsampled by emp_prob_pbs, it is only guaranteed if no block
+	 * of several conjuncts is.
+	 */
+	static double emp_prob_upper_bound(const Handle& pattern,
+	                                   const HandleSeq& db,
+	                                   double db_ratio=1.0);
+
 	/**
 	 * Calculate the empirical truth value of a pattern according to a
 	 * database db.
@@ -710,11 +846,15 @@ public:
 	static const Handle& emp_tv_key();
 
 	/**
-	 * Get/set the empirical truth value of the given pattern.
+	 * Get/set the empirical truth value of the given pattern over db,
+	 * as a value of the pattern atom, or in miner_cache() if open.
 	 */
-	static TruthValuePtr get_emp_tv(const Handle& pattern);
-	static void set_emp_tv(const Handle& pattern, TruthValuePtr etv);
-	static void set_emp_prob(const Handle& pattern, double ep);
+	static TruthValuePtr get_emp_tv(const Handle& pattern,
+	                                const HandleSeq& db);
+	static void set_emp_tv(const Handle& pattern, const HandleSeq& db,
+	                       TruthValuePtr etv);
+	static void set_emp_prob(const Handle& pattern, const HandleSeq& db,
+	                         double ep);
 
 	/**
 	 * Key of the joint-independent truth value estimate
@@ -723,17 +863,68 @@ public:
 
 	/**
 	 * Get/set the joint-independent truth value estimate of the given
-	 * pattern.
+	 * pattern over db, as a value of the pattern atom, or in
+	 * miner_cache() if open.
 	 */
-	static TruthValuePtr get_ji_tv_est(const Handle& pattern);
-	static void set_ji_tv_est(const Handle& pattern, TruthValuePtr etv);
+	static TruthValuePtr get_ji_tv_est(const Handle& pattern,
+	                                   const HandleSeq& db);
+	static void set_ji_tv_est(const Handle& pattern, const HandleSeq& db,
+	                          TruthValuePtr etv);
 
 	/**
 	 * Given 2 TVs, typically representing the empirical probability
 	 * and the probability estimate of a pattern, calculate the
 	 * Jensen-Shannon distance between them.
+	 *
+	 * The cdfs of the beta distributions corresponding to the TVs are
+	 * discretized over a given number of bins (jsd_bins() if
+	 * unspecified) and memoized (see beta_cdf), as the same TVs, such
+	 * as estimates, tend to be shared across patterns.
 	 */
 	static double jsd(TruthValuePtr l_tv, TruthValuePtr r_tv);
+	static double jsd(TruthValuePtr l_tv, TruthValuePtr r_tv, unsigned bins);
+
+	/**
+	 * Given 2 cdfs, described as in kld, return their Jensen-Shannon
+	 * distance.
+	 *
+	 * The probabilities of the 2 cdfs and their average are
+	 * calculated in a single pass and bins where both probabilities
+	 * are null are skipped, which is most of them for beta
+	 * distributions with high confidence.
+	 */
+	static double jsd(const std::vector<double>& l_cdf,
+	                  const std::vector<double>& r_cdf);
+
+	/**
+	 * Get/set the default number of bins used to discretize cdfs in
+	 * jsd. The default is 100.
+	 */
+	static unsigned jsd_bins();
+	static void set_jsd_bins(unsigned bins);
+
+	/**
+	 * Return the cdf of the beta distribution corresponding to the
+	 * given TV, discretized over bins regularly spaced right-end
+	 * points, as described in kld.
+	 *
+	 * Results are memoized in a bounded thread-safe cache, keyed by
+	 * the parameters of the beta distribution and the number of bins.
+	 */
+	static std::shared_ptr<const std::vector<double>> beta_cdf(TruthValuePtr tv,
+	                                                           unsigned bins);
+
+	/**
+	 * Calculate the cdf of a beta distribution with parameters alpha
+	 * and beta, discretized over bins regularly spaced right-end
+	 * points.
+	 *
+	 * The cdf being monotonic, the ranges of bins where it is exactly
+	 * 0 or 1 are found by bisection, and the incomplete beta function
+	 * is only evaluated in between, which gives the same result as
+	 * evaluating it on every bin.
+	 */
+	static std::vector<double> beta_cdf(double alpha, double beta, unsigned bins);
 
 	/**
 	 * Given 2 cdfs (cummulative distribution functions) return their
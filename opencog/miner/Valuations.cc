@@ -102,7 +102,8 @@ bool ValuationsBase::empty() const
 //////////////////
 
 SCValuations::SCValuations(const Variables& vars, const Handle& satset)
-	: ValuationsBase(vars)
+	: ValuationsBase(vars), _streamed(false), _size(0), _db(nullptr),
+	  _chunk_size(0)
 {
 	if (satset)
 	{
@@ -117,6 +118,97 @@ SCValuations::SCValuations(const Variables& vars, const Handle& satset)
 	}
 }
 
+SCValuations::SCValuations(const Variables& vars, bool streamed)
+	: ValuationsBase(vars), _streamed(streamed), _size(0), _db(nullptr),
+	  _chunk_size(0)
+{
+	if (_streamed)
+	{
+		_value_counts.resize(vars.size());
+		_eq_counts.resize(vars.size() * vars.size(), 0);
+	}
+}
+
+SCValuations::SCValuations(const Variables& vars, const Handle& pattern,
+                           const HandleSeq& db, unsigned chunk_size)
+	: ValuationsBase(vars), _streamed(true), _size(0), _pattern(pattern),
+	  _db(&db), _chunk_size(chunk_size)
+{
+	_eq_counts.resize(vars.size() * vars.size(), 0);
+	_sketches.resize(vars.size());
+}
+
+void SCValuations::consume(const HandleSeq& valuation, unsigned weight)
+{
+	if (not _streamed)
+	{
+		OC_ASSERT(weight == 1, "Weighted valuations must be streamed");
+		valuations.push_back(valuation);
+		return;
+	}
+
+	_size += weight;
+	unsigned nvars = valuation.size();
+	for (unsigned i = 0; i < nvars; i++)
+	{
+		if (is_sketched())
+			_sketches[i].add(MinerUtils::shallow_abstract_key(valuation[i]),
+			                 weight);
+		else
+			_value_counts[i][valuation[i]] += weight;
+		for (unsigned j = i + 1; j < nvars; j++)
+			if (content_eq(valuation[i], valuation[j]))
+				_eq_counts[i * nvars + j] += weight;
+	}
+}
+
+bool SCValuations::is_streamed() const
+{
+	return _streamed;
+}
+
+bool SCValuations::is_sketched() const
+{
+	return not _sketches.empty();
+}
+
+const CountMinSketch& SCValuations::sketch(unsigned var_idx) const
+{
+	return _sketches[var_idx];
+}
+
+void SCValuations::foreach_value(unsigned var_idx,
+                                 const std::function<void(const Handle&, unsigned)>& fun) const
+{
+	if (is_sketched())
+		MinerUtils::foreach_valuation(_pattern, *_db, _chunk_size,
+		                              [&](const HandleSeq& valuation) {
+			                              fun(valuation[var_idx], 1); });
+	else if (_streamed)
+		for (const auto& vc : _value_counts[var_idx])
+			fun(vc.first, vc.second);
+	else
+		for (const HandleSeq& valuation : valuations)
+			fun(valuation[var_idx], 1);
+}
+
+unsigned SCValuations::eq_count(unsigned i, unsigned j) const
+{
+	if (j < i)
+		std::swap(i, j);
+	if (i == j)
+		return size();
+
+	if (_streamed)
+		return _eq_counts[i * variables.size() + j];
+
+	unsigned count = 0;
+	for (const HandleSeq& valuation : valuations)
+		if (content_eq(valuation[i], valuation[j]))
+			count++;
+	return count;
+}
+
 HandleUCounter SCValuations::values(const Handle& var) const
 {
 	return values(index(var));
@@ -124,9 +216,12 @@ HandleUCounter SCValuations::values(const Handle& var) const
 
 HandleUCounter SCValuations::values(unsigned var_idx) const
 {
+	if (_streamed and not is_sketched())
+		return _value_counts[var_idx];
+
 	HandleUCounter vals;
-	for (const HandleSeq& valuation : valuations)
-		vals[valuation[var_idx]]++;
+	foreach_value(var_idx, [&](const Handle& value, unsigned count) {
+			vals[value] += count; });
 	return vals;
 }
 
@@ -142,20 +237,23 @@ bool SCValuations::operator<(const SCValuations& other) const
 
 unsigned SCValuations::size() const
 {
-	return valuations.size();
+	return _streamed ? _size : valuations.size();
 }
 
 bool SCValuations::empty() const
 {
-	return valuations.empty();
+	return size() == 0;
 }
 
 std::string SCValuations::to_string(const std::string& indent) const
 {
 	std::stringstream ss;
 	ss << indent << "variables:" << std::endl
-	   << oc_to_string(variables, indent + OC_TO_STRING_INDENT) << std::endl
-		<< indent << "valuations:" << std::endl
+	   << oc_to_string(variables, indent + OC_TO_STRING_INDENT) << std::endl;
+	if (_streamed)
+		ss << indent << (is_sketched() ? "sketched" : "streamed")
+		   << ", size = " << _size << std::endl;
+	ss << indent << "valuations:" << std::endl
 		<< oc_to_string(valuations, indent + OC_TO_STRING_INDENT) << std::endl
 	   << indent << "_var_idx = " << _var_idx;
 	return ss.str();
@@ -165,21 +263,78 @@ std::string SCValuations::to_string(const std::string& indent) const
 // Valuations //
 ////////////////
 
-Valuations::Valuations(const Handle& pattern, const HandleSeq& db)
+Valuations::Valuations(const Handle& pattern, const HandleSeq& db,
+                       unsigned chunk_size, unsigned jobs, bool sketched)
 	: ValuationsBase(MinerUtils::get_variables(pattern))
 {
+	// Sharded satisfying sets are materialized, defeating streaming
+	OC_ASSERT(jobs < 2 or chunk_size == 0,
+	          "Streamed valuations cannot be built over several jobs");
+
 	// Useless clauses (like redundant, constants, and more) are
 	// removed in order to simplify subsequent processing, and avoid
 	// warnings from the pattern matcher
 	Handle reduced_pattern = MinerUtils::remove_useless_clauses(pattern);
 	for (const Handle& cp : MinerUtils::get_component_patterns(reduced_pattern))
 	{
+		if (1 < jobs and MinerUtils::n_conjuncts(cp) == 1)
+		{
+			Handle satset = MinerUtils::sharded_satisfying_set(cp, db, jobs);
+			scvs.insert(SCValuations(MinerUtils::get_variables(cp), satset));
+			continue;
+		}
+		if (0 < chunk_size)
+		{
+			const Variables& cvars = MinerUtils::get_variables(cp);
+			SCValuations scv = sketched ?
+				SCValuations(cvars, cp, db, chunk_size)
+				: SCValuations(cvars, true);
+			MinerUtils::foreach_valuation(cp, db, chunk_size,
+			                              [&](const HandleSeq& valuation) {
+				                              scv.consume(valuation); });
+			scvs.insert(std::move(scv));
+			continue;
+		}
 		Handle satset = MinerUtils::restricted_satisfying_set(cp, db);
 		scvs.insert(SCValuations(MinerUtils::get_variables(cp), satset));
 	}
 	setup_size();
 }
 
+Valuations::Valuations(const Handle& pattern, const HandleUCounter& wdb,
+                       unsigned chunk_size)
+	: ValuationsBase(MinerUtils::get_variables(pattern))
+{
+	HandleSeq db = MinerUtils::db_trees(wdb);
+	Handle reduced_pattern = MinerUtils::remove_useless_clauses(pattern);
+	for (const Handle& cp : MinerUtils::get_component_patterns(reduced_pattern))
+	{
+		SCValuations scv(MinerUtils::get_variables(cp), true);
+		MinerUtils::foreach_valuation(cp, db, chunk_size,
+		                              [&](const HandleSeq& valuation) {
+			                              scv.consume(valuation,
+			                                          MinerUtils::valuation_weight(cp, valuation, wdb)); });
+		scvs.insert(std::move(scv));
+	}
+	setup_size();
+}
+
+Valuations::Valuations(const Handle& pattern, const DbView& db,
+                       unsigned chunk_size)
+	: ValuationsBase(MinerUtils::get_variables(pattern))
+{
+	Handle reduced_pattern = MinerUtils::remove_useless_clauses(pattern);
+	for (const Handle& cp : MinerUtils::get_component_patterns(reduced_pattern))
+	{
+		SCValuations scv(MinerUtils::get_variables(cp), true);
+		MinerUtils::foreach_valuation(cp, db, chunk_size,
+		                              [&](const HandleSeq& valuation) {
+			                              scv.consume(valuation); });
+		scvs.insert(std::move(scv));
+	}
+	setup_size();
+}
+
 Valuations::Valuations(const Variables& vars, const SCValuationsSet& sc)
 	: ValuationsBase(vars), scvs(sc)
 {
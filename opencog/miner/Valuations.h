@@ -23,10 +23,15 @@
 #ifndef OPENCOG_VALUATIONS_H_
 #define OPENCOG_VALUATIONS_H_
 
+#include <functional>
+
 #include <opencog/util/empty_string.h>
 #include <opencog/atoms/base/Handle.h>
 #include <opencog/atoms/core/Variables.h>
 
+#include "CountMinSketch.h"
+#include "DbView.h"
+
 namespace opencog
 {
 
@@ -108,6 +113,72 @@ public:
 	 */
 	SCValuations(const Variables& variables, const Handle& satset=Handle::UNDEFINED);
 
+	/**
+	 * Construct empty SCValuations, to be filled with consume. If
+	 * streamed is true then rows of values are not retained, only
+	 * aggregated counters, that is the count of each value of each
+	 * variable, and the number of rows where any pair of variables
+	 * have equal values. This is all MinerUtils::focus_shallow_abstract
+	 * needs, and keeps the memory bounded by the number of distinct
+	 * values rather than the number of groundings.
+	 */
+	SCValuations(const Variables& variables, bool streamed);
+
+	/**
+	 * Construct empty streamed SCValuations of the groundings of
+	 * pattern over db, to be filled with consume, that instead of the
+	 * count of each value of each variable only retain a Count-Min
+	 * sketch of the counts of their shallow abstractions (see
+	 * MinerUtils::shallow_abstract_key), so that the memory is
+	 * bounded by the size of the sketches rather than the number of
+	 * distinct values. The values are obtained again, when needed, by
+	 * streaming the groundings of pattern over db again, chunk_size
+	 * data trees at a time, see foreach_value. db must thus outlive
+	 * the SCValuations.
+	 */
+	SCValuations(const Variables& variables, const Handle& pattern,
+	             const HandleSeq& db, unsigned chunk_size);
+
+	/**
+	 * Add a row of values, ordered as variables. In streamed mode
+	 * only update the aggregated counters, the row counting as weight
+	 * rows, see MinerUtils::valuation_weight. Only streamed mode
+	 * supports weights other than 1.
+	 */
+	void consume(const HandleSeq& valuation, unsigned weight=1);
+
+	/**
+	 * Return true iff rows of values are not retained, see above.
+	 */
+	bool is_streamed() const;
+
+	/**
+	 * Return true iff only sketches of the value counts are retained,
+	 * see above.
+	 */
+	bool is_sketched() const;
+
+	/**
+	 * Return the sketch of the counts of the shallow abstractions of
+	 * the values of the variable at var_idx, in sketched mode.
+	 */
+	const CountMinSketch& sketch(unsigned var_idx) const;
+
+	/**
+	 * Call fun on each value of the variable at var_idx, with its
+	 * count. In streamed mode each distinct value is visited once,
+	 * in sketched mode the groundings are streamed again and each
+	 * row is visited, with count 1.
+	 */
+	void foreach_value(unsigned var_idx,
+	                   const std::function<void(const Handle&, unsigned)>& fun) const;
+
+	/**
+	 * Return the number of rows where the variables at indices i and
+	 * j have equal values.
+	 */
+	unsigned eq_count(unsigned i, unsigned j) const;
+
 	/**
 	 * Return all counted values corresponding to var.
 	 */
@@ -141,8 +212,26 @@ public:
 	std::string to_string(const std::string& indent=empty_string) const;
 
 	// Actual valuations, sequence of tuples of values associated to
-	// each variable.
+	// each variable. Empty in streamed mode.
 	HandleSeqSeq valuations;
+
+private:
+	bool _streamed;
+
+	// Aggregated counters, only used in streamed mode. _eq_counts is
+	// a flattened square matrix of which only the upper triangle is
+	// filled. In sketched mode _value_counts is replaced by
+	// _sketches.
+	unsigned _size;
+	std::vector<HandleUCounter> _value_counts;
+	std::vector<unsigned> _eq_counts;
+	std::vector<CountMinSketch> _sketches;
+
+	// Pattern, db and chunk size to stream the groundings again from,
+	// only used in sketched mode.
+	Handle _pattern;
+	const HandleSeq* _db;
+	unsigned _chunk_size;
 };
 
 typedef std::set<SCValuations> SCValuationsSet;
@@ -159,8 +248,40 @@ public:
 	/**
 	 * Given a pattern and db (ground terms), calculate its
 	 * valuations.
+	 *
+	 * If chunk_size is positive, then the groundings of each
+	 * component are streamed through streamed SCValuations, chunk_size
+	 * data trees at a time (see MinerUtils::foreach_valuation), so
+	 * that only aggregated counters are retained.
+	 *
+	 * If jobs is above 1, the satisfying set of each single conjunct
+	 * component is calculated over shards of the db on that many
+	 * threads (see MinerUtils::sharded_satisfying_set), then
+	 * materialized, thus chunk_size must then be zero.
+	 *
+	 * If sketched is true, and chunk_size positive, then the streamed
+	 * SCValuations only retain sketches of the value counts, see
+	 * SCValuations, db must then outlive the Valuations.
+	 */
+	Valuations(const Handle& pattern, const HandleSeq& db,
+	           unsigned chunk_size=0, unsigned jobs=1,
+	           bool sketched=false);
+
+	/**
+	 * Like above over a weighted db (see MinerUtils::weigh_db), each
+	 * valuation counting as its weight. The SCValuations are always
+	 * streamed.
+	 */
+	Valuations(const Handle& pattern, const HandleUCounter& wdb,
+	           unsigned chunk_size=0);
+
+	/**
+	 * Like above over a view of a db (see DbView), only materializing
+	 * chunk_size data trees at a time. The SCValuations are always
+	 * streamed.
 	 */
-	Valuations(const Handle& pattern, const HandleSeq& db);
+	Valuations(const Handle& pattern, const DbView& db,
+	           unsigned chunk_size=0);
 	Valuations(const Variables& variables, const SCValuationsSet& scvs);
 	Valuations(const Variables& variables);
 
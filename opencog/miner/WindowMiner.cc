@@ -0,0 +1,131 @@
+/*
+ * WindowMiner.cc
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include "WindowMiner.h"
+
+#include <opencog/util/oc_assert.h>
+
+namespace opencog
+{
+
+WindowMiner::WindowMiner(const MinerParameters& param, double win)
+	: miner(param), window(win)
+{
+}
+
+void WindowMiner::add(const Handle& data_tree, double timestamp)
+{
+	update({data_tree}, timestamp);
+}
+
+void WindowMiner::advance(double timestamp)
+{
+	update({}, timestamp);
+}
+
+const PatternForest& WindowMiner::get_patterns() const
+{
+	return patterns;
+}
+
+HandleSeq WindowMiner::get_db() const
+{
+	HandleSeq db;
+	for (const auto& tdt : data_trees)
+		db.push_back(tdt.second);
+	return db;
+}
+
+void WindowMiner::update(const HandleSeq& added, double timestamp)
+{
+	OC_ASSERT(data_trees.empty() or data_trees.back().first <= timestamp,
+	          "Timestamps must not decrease");
+
+	for (const Handle& dt : added)
+		data_trees.emplace_back(timestamp, dt);
+
+	HandleSeq removed;
+	while (not data_trees.empty() and
+	       data_trees.front().first < timestamp - window) {
+		removed.push_back(data_trees.front().second);
+		data_trees.pop_front();
+	}
+
+	if (added.empty() and removed.empty())
+		return;
+
+	// Update the occurrences of the groundings of the counted
+	// patterns, which give their supports
+	for (auto& po : occurrences) {
+		for (const Handle& dt : added)
+			count_occurrences(po.first, dt, 1, po.second);
+		for (const Handle& dt : removed)
+			count_occurrences(po.first, dt, -1, po.second);
+	}
+	HandleSeq db = get_db();
+	patterns = miner.mine_incremental(patterns, db, added, removed,
+	                                  [&](const Handle& pattern) {
+		return (unsigned)occurrences.at(pattern).size(); });
+
+	// Count the occurrences of the new patterns over the window, and
+	// forget the dropped ones
+	decltype(occurrences) counted;
+	for (unsigned i = 0; i < patterns.size(); i++) {
+		const Handle& pattern = patterns.pattern(i);
+		if (not is_counted(pattern))
+			continue;
+		auto it = occurrences.find(pattern);
+		if (it != occurrences.end()) {
+			counted.emplace(pattern, std::move(it->second));
+			continue;
+		}
+		HandleContentSizeMap& counts = counted[pattern];
+		for (const Handle& dt : db)
+			count_occurrences(pattern, dt, 1, counts);
+	}
+	occurrences.swap(counted);
+}
+
+bool WindowMiner::is_counted(const Handle& pattern)
+{
+	return MinerUtils::n_conjuncts(pattern) == 1
+		and not MinerUtils::totally_abstract(pattern);
+}
+
+void WindowMiner::count_occurrences(const Handle& pattern,
+                                    const Handle& data_tree,
+                                    int inc,
+                                    HandleContentSizeMap& counts)
+{
+	MinerUtils::foreach_grounding(pattern, {data_tree}, 0,
+	                              [&](const Handle& grounding) {
+		if (0 < inc) {
+			counts[grounding]++;
+			return;
+		}
+		auto it = counts.find(grounding);
+		if (it != counts.end() and --it->second == 0)
+			counts.erase(it);
+	});
+}
+
+} // namespace opencog
@@ -0,0 +1,132 @@
+/*
+ * WindowMiner.h
+ *
+ * Copyright (C) 2026 SingularityNET Foundation
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#ifndef OPENCOG_WINDOW_MINER_H_
+#define OPENCOG_WINDOW_MINER_H_
+
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include <opencog/atoms/base/Handle.h>
+
+#include "Miner.h"
+#include "MinerUtils.h"
+#include "PatternForest.h"
+
+namespace opencog
+{
+
+/**
+ * Mine the frequent patterns of a stream of timestamped data trees
+ * over a sliding window, that is the data trees of timestamps within
+ * window of the last one.
+ *
+ * Instead of mining each window from scratch, the frequent patterns
+ * are maintained online as data trees enter and leave the window,
+ * their supports being incremented and decremented, new frequent
+ * patterns being searched from the data trees entering the window
+ * only, and patterns no longer frequent being dropped, see
+ * Miner::mine_incremental.
+ *
+ * The support of a unary pattern is the number of its distinct
+ * groundings, which may be shared by several data trees, thus the
+ * number of data trees of the window each grounding occurs in is
+ * maintained, the support being the number of groundings occurring
+ * in at least one.
+ *
+ * Data trees are assumed distinct, like the data trees of a db.
+ */
+class WindowMiner
+{
+public:
+	/**
+	 * CTor, given the miner parameters, with the restrictions of
+	 * Miner::mine_incremental, and the window length, in the unit of
+	 * the timestamps.
+	 */
+	WindowMiner(const MinerParameters& param, double window);
+
+	/**
+	 * Add a data tree with its timestamp, which must not be lower
+	 * than the previous one, and remove the data trees that left the
+	 * window, updating the frequent patterns accordingly.
+	 */
+	void add(const Handle& data_tree, double timestamp);
+
+	/**
+	 * Like add but without data tree, to only let time pass.
+	 */
+	void advance(double timestamp);
+
+	/**
+	 * Return the frequent patterns of the current window, with their
+	 * supports.
+	 */
+	const PatternForest& get_patterns() const;
+
+	/**
+	 * Return the data trees of the current window, from the oldest.
+	 */
+	HandleSeq get_db() const;
+
+private:
+	/**
+	 * Remove the data trees that left the window at timestamp and
+	 * update the patterns given the added data trees.
+	 */
+	void update(const HandleSeq& added, double timestamp);
+
+	/**
+	 * Return true iff the support of pattern is maintained by
+	 * counting the occurrences of its groundings, that is pattern is
+	 * unary but not totally abstract.
+	 */
+	static bool is_counted(const Handle& pattern);
+
+	/**
+	 * Add inc, 1 or -1, to the occurrences of the groundings of
+	 * pattern in data_tree, removing the groundings no longer
+	 * occurring.
+	 */
+	static void count_occurrences(const Handle& pattern,
+	                              const Handle& data_tree,
+	                              int inc,
+	                              HandleContentSizeMap& counts);
+
+	Miner miner;
+	double window;
+
+	// Data trees of the window, with their timestamps, from the oldest
+	std::deque<std::pair<double, Handle>> data_trees;
+
+	PatternForest patterns;
+
+	// Number of data trees of the window each grounding of each
+	// counted pattern occurs in, see is_counted
+	std::unordered_map<Handle, HandleContentSizeMap,
+	                   HandleContentHash, HandleContentEqual> occurrences;
+};
+
+} // ~namespace opencog
+
+#endif /* OPENCOG_WINDOW_MINER_H_ */
@@ -46,10 +46,25 @@
 (define default-maximum-spcial-conjuncts 1)
 (define default-maximum-cnjexp-variables 2)
 (define default-surprisingness 'isurp)
+(define default-surprisingness-top-k -1)
+(define default-output-mode 'all)
+(define default-top-k -1)
+(define default-time-budget -1)
+(define default-memory-budget -1)
+
+;; Number of iterations of each round of forward chaining when a time
+;; or memory budget, a checkpoint or top-k is set, see fc-by-rounds.
+(define budget-round-iterations 10)
+(define default-checkpoint "")
+(define default-checkpoint-interval 60)
 (define default-db-ratio 1)
 (define default-enable-type #f)
 (define default-enable-glob #f)
 (define default-ignore-variables '())
+(define default-native #f)
+(define default-warm-start '())
+(define default-cache "")
+(define default-cache-capacity -1)
 
 ;; For some crazy reason I need to repaste absolutely-true here while
 ;; it is already defined in ure.
@@ -155,6 +170,13 @@
     dt
     db-cpt
 
+  The number of occurrences of dt in db is recorded as the
+  multiplicity of that member link, see cog-set-multiplicity!, used by
+  cog-weighted-support and cog-mine-cpp, replacing its previous
+  multiplicity if the member link already existed, so that filling a
+  db concept twice with the same db does not count its data trees
+  twice.
+
   db can be
   1. a Scheme list
   2. an Atomese List or Set
@@ -164,8 +186,15 @@
   db-cpt is returned.
 "
   (let* ((db-lst (get-db-lst db))
-         (mk-member (lambda (dt) (Member dt db-cpt))))
-    (for-each mk-member db-lst))
+         ;; Duplicates of dt share the same member link
+         (members (map (lambda (dt) (Member dt db-cpt)) db-lst))
+         (count! (lambda (member)
+                   (cog-set-multiplicity!
+                    member (Number (+ 1 (cog-multiplicity member)))))))
+    ;; Count the occurrences of each data tree in db only
+    (for-each (lambda (member) (cog-set-multiplicity! member (Number 0)))
+              members)
+    (for-each count! members))
   db-cpt)
 
 (define (configure-mandatory-rules pm-rbs)
@@ -535,6 +564,182 @@
          (gl (Get vardecl (And (Present target) precond))))
     (cog-execute! gl)))
 
+(define (filter-output-mode om patterns db ms)
+"
+  Given an output mode om, a list of patterns with enough support, a db
+  concept and a minimum support ms, return the patterns to output, that
+  is all of them if om is 'all, the closed ones if om is 'closed and the
+  maximal ones if om is 'maximal, see cog-closed? and cog-maximal?.
+
+  The minsup evaluations of the filtered out patterns are removed, so
+  that they are ignored by the surprisingness rules as well.
+"
+  (let* ((output? (cond ((equal? om 'closed) (lambda (pat) (cog-closed? pat db)))
+                        ((equal? om 'maximal) (lambda (pat) (cog-maximal? pat db ms)))
+                        (else (lambda (pat) #t)))))
+    (filter (lambda (pat) (or (output? pat) (discard-pattern! pat db ms)))
+            patterns)))
+
+(define (kth-support tk supports)
+"
+  Given tk and a list of supports, return the tk-th greatest one, or 0
+  if there are no more than tk supports.
+"
+  (if (< tk (length supports))
+      (list-ref (sort supports >) (- tk 1))
+      0))
+
+(define (filter-top-k tk patterns db ms)
+"
+  Given tk, a list of patterns with enough support, a db concept and a
+  minimum support ms, return the tk most frequent patterns (more in case
+  of ties), see cog-support. The minsup evaluations of the other
+  patterns are removed, like in filter-output-mode.
+"
+  (let* ((supports (map (lambda (pat) (cog-number (cog-support pat db)))
+                        patterns))
+         (kth (kth-support tk supports)))
+    (filter-map (lambda (pat sup)
+                  (if (<= kth sup) pat (discard-pattern! pat db ms)))
+                patterns supports)))
+
+(define (raise-minsup tk patterns db ms)
+"
+  Given tk, a list of patterns with enough support, a db concept and a
+  minimum support ms (a number node), raise the minimum support to the
+  support of the tk-th most frequent pattern if greater than ms, as no
+  pattern, nor its specializations, below it can be among the tk most
+  frequent ones.
+
+  Return a pair (new-ms . retained-patterns). When raised, the minsup
+  evaluations of the patterns are replaced by minsup evaluations with
+  the new minimum support for the retained patterns, and removed for
+  the others, so that the next round of forward chaining only expands
+  the retained ones.
+"
+  (let* ((supports (map (lambda (pat) (cog-number (cog-support pat db)))
+                        patterns))
+         (kth (kth-support tk supports)))
+    (if (<= kth (cog-number ms))
+        (cons ms patterns)
+        (let* ((new-ms (Number kth))
+               (retained (filter-map (lambda (pat sup)
+                                       (discard-pattern! pat db ms)
+                                       (and (<= kth sup)
+                                            (begin (minsup-eval-true pat db new-ms)
+                                                   pat)))
+                                     patterns supports)))
+          (miner-logger-debug "Raise minimum support to ~a" kth)
+          (cons new-ms retained)))))
+
+(define (warm-start-frontier previous initpat db ms mv enable-type enable-glob
+                             ignore-variables)
+"
+  Given patterns previously mined from initpat over a db concept with
+  a higher minimum support than ms, return the frontier pruned by the
+  previous run, that is the shallow specializations of initpat and
+  the previous patterns reaching ms that are not previous patterns
+  themselves, see cog-shallow-specialize. The specializations of the
+  previous patterns that are not in the frontier have already been
+  explored, as they are previous patterns themselves.
+"
+  (let* ((shaspes (lambda (pat)
+                    (cog-outgoing-set
+                     (cog-shallow-specialize
+                      pat db ms (Number (min 9 mv))
+                      (cog-new-node 'PredicateNode "enable-type"
+                                    (cog-new-stv (if enable-type 1 0) 1))
+                      (cog-new-node 'PredicateNode "enable-glob"
+                                    (cog-new-stv (if enable-glob 1 0) 1))
+                      (List ignore-variables))))))
+    (delete-duplicates
+     (filter (lambda (pat) (not (member pat previous)))
+             (append-map shaspes (cons initpat previous))))))
+
+(define (discard-pattern! pattern db ms)
+"
+  Remove the minsup evaluation of pattern, so that it is ignored by
+  the surprisingness rules, and return #f.
+"
+  (cog-extract-recursive! (minsup-eval pattern db ms))
+  #f)
+
+(define (within-budget? start-time tb mb)
+"
+  Return #t iff less than tb seconds have elapsed since start-time (as
+  returned by get-internal-real-time) and the resident memory of the
+  process is below mb bytes. A negative tb or mb means no budget.
+"
+  (let* ((elapsed (/ (- (get-internal-real-time) start-time)
+                     internal-time-units-per-second)))
+    (and (or (< tb 0) (< elapsed tb))
+         (or (< mb 0) (< (cog-resident-memory) mb)))))
+
+(define (fc-by-rounds pm-rbs source db ms mi start-time tb mb tk on-round)
+"
+  Like (cog-fc pm-rbs source) with maximum iterations mi, but run the
+  forward chainer by rounds of budget-round-iterations iterations,
+  sourcing each round from all patterns found so far, and stop once the
+  time budget tb or memory budget mb is exhausted, see within-budget?,
+  or a round does not find new patterns. The patterns found so far are
+  left in the current atomspace, as with cog-fc.
+
+  If tk is positive, the minimum support is raised after each round to
+  the support of the tk-th most frequent pattern found so far, see
+  raise-minsup, so that the next rounds do not expand patterns that
+  cannot be among the tk most frequent ones.
+
+  After each round (on-round patterns last?) is called, with the set of
+  patterns found so far and whether it is the last round.
+
+  Return the final minimum support.
+"
+  (let loop ((sources source)
+             (ms ms)
+             (remaining mi)
+             (npatterns 0))
+    (let* ((round-mi (if (< remaining 0)
+                         budget-round-iterations
+                         (min remaining budget-round-iterations)))
+           (dummy (ure-set-maximum-iterations pm-rbs round-mi))
+           (dummy (cog-fc pm-rbs sources))
+           (patterns (fetch-patterns db ms))
+           (patterns-lst (cog-outgoing-set patterns))
+           (remaining (if (< remaining 0) remaining (- remaining round-mi)))
+           (last? (or (= remaining 0)
+                      (not (within-budget? start-time tb mb))
+                      (= (length patterns-lst) npatterns))))
+      (on-round patterns last?)
+      (if last?
+          (begin (miner-logger-debug "Stop pattern mining after ~a patterns"
+                                     (length patterns-lst))
+                 ms)
+          (let* ((raised (if (< 0 tk)
+                             (raise-minsup tk patterns-lst db ms)
+                             (cons ms patterns-lst)))
+                 (ms (car raised))
+                 (patterns-lst (cdr raised)))
+            (loop (Set (map (lambda (pat) (minsup-eval pat db ms)) patterns-lst))
+                  ms
+                  remaining
+                  (length patterns-lst)))))))
+
+(define (checkpoint-saver filename interval db ms options)
+"
+  Return a function to pass to fc-by-rounds, saving the patterns found
+  so far, their supports and the options of the run in filename every
+  interval seconds and after the last round, see
+  cog-miner-save-checkpoint.
+"
+  (let ((last-save (get-internal-real-time)))
+    (lambda (patterns last?)
+      (when (or last?
+                (<= interval (/ (- (get-internal-real-time) last-save)
+                                internal-time-units-per-second)))
+        (cog-miner-save-checkpoint (Concept filename) patterns db ms
+                                   (Concept options))
+        (set! last-save (get-internal-real-time))))))
+
 (define* (conjunct-pattern nconj)
 "
   Create a pattern of nconj conjunctions.
@@ -630,6 +835,28 @@
                    (surp default-surprisingness)
                    (surprisingness default-surprisingness)
 
+                   ;; Number of most surprising patterns to return
+                   (surptopk default-surprisingness-top-k)
+                   (surprisingness-top-k default-surprisingness-top-k)
+
+                   ;; Which patterns to output, all, closed or maximal
+                   (outmode default-output-mode)
+                   (output-mode default-output-mode)
+
+                   ;; Number of most frequent patterns to return
+                   (topk default-top-k)
+                   (top-k default-top-k)
+
+                   ;; Time budget in seconds
+                   (time-budget default-time-budget)
+
+                   ;; Resident memory budget in bytes
+                   (memory-budget default-memory-budget)
+
+                   ;; Checkpoint file and interval in seconds
+                   (checkpoint default-checkpoint)
+                   (checkpoint-interval default-checkpoint-interval)
+
                    ;; db-ratio
                    (db-ratio default-db-ratio)
 
@@ -640,7 +867,18 @@
                    (enable-glob default-enable-glob)
 
                    ;; Variables to leave untouched
-                   (ignore-variables default-ignore-variables))
+                   (ignore-variables default-ignore-variables)
+
+                   ;; Run the C++ miner instead of the rule engine
+                   (native default-native)
+
+                   ;; Patterns previously mined with a higher minimum support
+                   (warm-start default-warm-start)
+
+                   ;; Cache of supports and truth values, and its
+                   ;; capacity in bytes
+                   (cache default-cache)
+                   (cache-capacity default-cache-capacity))
 "
   Mine patterns in db (data trees, a.k.a. grounded hypergraphs) with minimum
   support ms, optionally using mi iterations and starting from the initial
@@ -660,10 +898,21 @@
                    #:maximum-spcial-conjuncts mspc  (or #:maxspcjn mspc)
                    #:maximum-cnjexp-variables mcev  (or #:maxcevar mcev)
                    #:surprisingness su              (or #:surp su)
+                   #:surprisingness-top-k sk        (or #:surptopk sk)
+                   #:output-mode om                 (or #:outmode om)
+                   #:top-k tk                       (or #:topk tk)
+                   #:time-budget tb
+                   #:memory-budget mb
+                   #:checkpoint cf
+                   #:checkpoint-interval ci
                    #:db-ratio dbr
                    #:enable-type et
                    #:enable-glob eg
-                   #:ignore-variables iv)
+                   #:ignore-variables iv
+                   #:native nt
+                   #:warm-start ws
+                   #:cache ca
+                   #:cache-capacity cc)
 
   db: Collection of data trees to mine. It can be given in 3 forms
 
@@ -766,7 +1015,9 @@
 
       'jsdsurp:    Jensen-Shannon Distance based surprisingness.
                    The type of surprisingness is determined by the way
-                   the truth value estimate is calculated.
+                   the truth value estimate is calculated. The number of
+                   bins used to discretize the distributions can be set
+                   with cog-set-jsd-bins! (100 by default).
 
       'none:       No surprisingness measure is applied.
 
@@ -775,6 +1026,68 @@
       a predicate indicating their surprisingness. Otherwise, if 'none
       is selected then it returns a (scheme) list of patterns.
 
+  sk: [optional, default=-1] Only return the sk most surprising patterns.
+      A negative value means disabled, in which case all patterns are
+      returned. For 'isurp and 'nisurp, cheap upper bounds of the
+      surprisingness are calculated first, from the probability estimates
+      of the pattern partitions, so that the costly empirical probability
+      is only calculated for patterns that may still enter the top sk.
+      For other modes, the surprisingness of all patterns is calculated
+      then only the top sk are kept.
+
+  om: [optional, default='all] Which mined patterns to output, before
+      applying surprisingness. The following supported modes are:
+
+      'all:     All patterns with enough support.
+
+      'closed:  Only closed patterns, that is patterns without
+                specialization of equal support.
+
+      'maximal: Only maximal patterns, that is patterns without
+                specialization with enough support.
+
+      Specializations are here shallow specializations, thus
+      specializations by conjunction expansion are not considered.
+      Closed patterns retain the supports of all patterns, as the
+      support of a pattern is the maximum support of its closed
+      specializations, while maximal patterns are the most compact but
+      lose these supports.
+
+  tk: [optional, default=-1] Only return the tk most frequent patterns
+      (more in case of ties), before applying surprisingness. A negative
+      value means disabled. When enabled, ms is only the initial minimum
+      support, 1 unless provided, so that it does not need to be tuned.
+      The rule engine is then run by rounds, see tb and mb, raising the
+      minimum support after each round to the support of the tk-th most
+      frequent pattern found so far, so that the following rounds only
+      expand patterns that may be among the tk most frequent ones. The
+      C++ miner (native) raises it as it goes.
+
+  tb: [optional, default=-1] Wall-clock time budget in seconds. A negative
+      value means no budget.
+
+  mb: [optional, default=-1] Resident memory budget of the process in
+      bytes. A negative value means no budget.
+
+      If tb or mb is set, the forward chainer is run by rounds of a few
+      iterations, each round being sourced by all patterns found so far,
+      till mi iterations have been used, no new pattern is found, or a
+      budget is exhausted. In the latter case mining stops gracefully,
+      surprisingness is skipped and the patterns found so far are
+      returned, as if su were 'none. Budgets are only checked between
+      rounds, thus may be slightly exceeded.
+
+  cf: [optional, default=\"\"] Checkpoint file. If not empty, the forward
+      chainer is run by rounds as above, and the patterns found so far,
+      with their supports and the options of the run, are saved in cf
+      every ci seconds and at the end of mining. If cf already exists, mining
+      is resumed from it, its patterns being the sources of the first
+      round. An error is raised if its options or its db differ from the
+      current ones.
+
+  ci: [optional, default=60] Minimum number of seconds between 2 saves of
+      the checkpoint file.
+
   dbr: [optional, default=1] parameter to control how much
        downsampling is taking place to estimate the empirical probability of
        the patterns during surprisingness measure. The surprisingness rules
@@ -818,6 +1131,46 @@
       instance in temporal mining, where the temporal variable must be left
       untouched.
 
+  nt: [optional, default=#f] Flag whether to mine with the C++ miner,
+      see cog-mine-cpp, and calculate surprisingness natively, see
+      cog-surp-top-k, instead of running the rule engine. This avoids
+      the overhead of the rule engine and of the Get queries, and
+      explores the search space exhaustively, thus jb, mi and cp are
+      ignored. et, eg and iv are not supported and ignored with a
+      warning. Checkpoints are those of the C++ miner, thus cannot be
+      shared with runs of the rule engine. See also cog-mine-native.
+
+  ws: [optional, default=()] Patterns previously mined over the same db
+      with a higher minimum support and otherwise the same options, as
+      returned by cog-mine with su set to 'none, given as a scheme list
+      or an Atomese set. Mining is warm started from them, so that
+      lowering ms progressively does not require to mine from scratch.
+      Only the specializations pruned by the previous run are explored,
+      with the rule engine by sourcing the forward chainer with the
+      frontier pruned by the previous run, see warm-start-frontier, and
+      with nt, see cog-mine-cpp, which requires om to be 'all, tk to be
+      negative and ce to be #f. With the rule engine and ce (with mc
+      above 1), conjunctions of previous patterns may have newly
+      reached ms, thus the previous patterns are added to the sources
+      of the forward chainer instead, like the patterns of a resumed
+      checkpoint, and explored again.
+
+  ca: [optional, default=\"\"] Persistent cache file. If not empty, the
+      supports, empirical truth values and joint independent truth value
+      estimates of patterns are looked up in ca before being calculated,
+      and recorded in it, keyed by pattern and db, so that repeated
+      analyses over the same db do not calculate them again. ca is
+      loaded at the start of mining, if it exists, and saved at the end,
+      see cog-miner-open-cache. While the cache is open these values are
+      memoized in it instead of on the pattern atoms.
+
+  cc: [optional, default=-1] Capacity of the cache in bytes. If positive,
+      the least recently used entries of the cache are evicted beyond
+      cc bytes, and the cache is used even if ca is empty, in memory
+      only, to bound the memory of the memoized values. A negative
+      value means no capacity. The hit rate of the cache is logged at
+      the end of mining, see cog-miner-cache-statistics.
+
   Under the hood it will create a rule base and a query for the rule
   engine, configure it according to the user's options and run it.
   Everything takes place in a child atomspace. After the job is done
@@ -869,6 +1222,7 @@
         (to-number
          (cond ((num-diff? minimum-support default-minimum-support) minimum-support)
                ((num-diff? minsup default-minimum-support) minsup)
+               ((< 0 tk) 1)
                (else default-minimum-support)))))
 
   ;; Set initial pattern, a function to use the current atomspace at
@@ -987,6 +1341,82 @@
           ((diff? surp default-surprisingness) surp)
           (else default-surprisingness)))
 
+  ;; Set surprisingness top-k
+  (define sk
+    (to-number
+     (cond ((num-diff? surprisingness-top-k default-surprisingness-top-k) surprisingness-top-k)
+           ((num-diff? surptopk default-surprisingness-top-k) surptopk)
+           (else default-surprisingness-top-k))))
+
+  ;; Set top-k
+  (define tk
+    (to-number
+     (cond ((num-diff? top-k default-top-k) top-k)
+           ((num-diff? topk default-top-k) topk)
+           (else default-top-k))))
+
+  ;; Set time and memory budgets
+  (define tb (to-number time-budget))
+  (define mb (to-number memory-budget))
+  (define budget? (or (<= 0 tb) (<= 0 mb)))
+
+  ;; Set checkpoint
+  (define cf checkpoint)
+  (define ci (to-number checkpoint-interval))
+  (define checkpoint? (not (string-null? cf)))
+
+  ;; Set cache
+  (define cc (to-number cache-capacity))
+  (define cache? (or (not (string-null? cache)) (< 0 cc)))
+
+  ;; Set warm start patterns
+  (define ws (if (cog-atom? warm-start)
+                 (cog-outgoing-set warm-start)
+                 warm-start))
+  (define start-time (get-internal-real-time))
+
+  ;; Set output mode
+  (define om
+    (cond ((diff? output-mode default-output-mode) output-mode)
+          ((diff? outmode default-output-mode) outmode)
+          (else default-output-mode)))
+
+  ;; Restrictions of the search not supported by the C++ miner
+  (define unsupported-restrictions?
+    (or enable-type enable-glob (not (null? ignore-variables))))
+
+  ;; Restrictions of the search of the C++ miner, see cog-mine-cpp
+  (define (restriction-options)
+    (map (lambda (name value) (List (Concept name) value))
+         (list "maximum-conjuncts" "maximum-variables"
+               "maximum-cnjexp-variables" "maximum-spcial-conjuncts"
+               "enforce-specialization")
+         (list (Number (if ce mc 1)) (Number mv) (Number mcev) (Number mspc)
+               (Number (if es 1 0)))))
+
+  ;; Options of the C++ miner, see cog-mine-cpp
+  (define (native-options)
+    (when unsupported-restrictions?
+      (miner-logger-warn "Types, globs and ignored variables are not supported by the C++ miner"))
+    (List
+     (restriction-options)
+     (map (lambda (name value) (List (Concept name) value))
+          (list "output-mode" "top-k"
+                "time-budget" "memory-budget" "checkpoint-interval")
+          (list (Concept (symbol->string om)) (Number tk)
+                (Number tb) (Number mb) (Number ci)))
+     (if checkpoint? (List (Concept "checkpoint") (Concept cf)) '())
+     (if (null? ws) '() (List (Concept "warm-start") (Set ws)))))
+
+  ;; Save and close the persistent cache, if any, and go back to the
+  ;; parent atomspace
+  (define (end-mine parent-as)
+    (when cache?
+      (miner-logger-debug "Cache statistics (hits misses evictions entries bytes hit-rate):\n~a"
+                          (cog-miner-cache-statistics))
+      (cog-miner-close-cache))
+    (cog-set-atomspace! parent-as))
+
   (let* (;; Create a temporary child atomspace for the URE
          (tmp-as (cog-new-atomspace (cog-atomspace)))
          (parent-as (cog-set-atomspace! tmp-as))
@@ -998,6 +1428,7 @@
                      (fill-db-cpt (random-db-cpt) db)
                      ;; Otherwise db is already a concept
                      db))
+         (dummy (when cache? (cog-miner-open-cache (Concept cache) db-cpt (Number cc))))
          (db-size (get-cardinality db-cpt))
          (ms (get-minimum-support db-size))
          (ms-n (to-number-node ms))
@@ -1006,7 +1437,7 @@
     (if (not es)
         ;; The initial pattern doesn't have enough support, thus the
         ;; solution set is empty.
-        (begin (cog-set-atomspace! parent-as)
+        (begin (end-mine parent-as)
                (miner-logger-debug "Initial pattern:\n~a" (get-initial-pattern))
                (miner-logger-debug "Does not have enough support (min support = ~a)" ms)
                (miner-logger-debug "Abort pattern mining")
@@ -1016,60 +1447,207 @@
         ;; The initial pattern has enough support, let's configure the
         ;; rule engine and run the pattern mining query
         (let* (;; Configure pattern miner forward chainer
-               (source (minsup-eval-true (get-initial-pattern) db-cpt ms-n))
+               (initial-source (minsup-eval-true (get-initial-pattern) db-cpt ms-n))
+               ;; Options affecting the results, on one line, to check
+               ;; that a checkpoint is resumed with the same ones
+               (options (string-map (lambda (c) (if (char=? c #\newline) #\space c))
+                                    (format #f "~a" (list ms mc mv mspc mcev ce es
+                                                          enable-type enable-glob
+                                                          ignore-variables
+                                                          (get-initial-pattern)))))
+               (resume? (and checkpoint? (file-exists? cf) (not native)))
+               (dummy (when (and resume?
+                                 (not (equal? options
+                                              (cog-miner-checkpoint-options (Concept cf)
+                                                                            db-cpt))))
+                        (error (format #f "Checkpoint ~a has different options" cf))))
+               ;; Warm start from the frontier pruned by the previous
+               ;; run, see warm-start-frontier, the previous patterns
+               ;; being only added to the results. With conjunction
+               ;; expansion conjunctions of previous patterns may have
+               ;; newly reached ms as well, thus the previous patterns
+               ;; are sourced instead, and explored again.
+               (frontier? (and (not native) (not (null? ws))
+                               (not (and ce (< 1 mc)))))
+               (dummy (when frontier?
+                        (for-each (lambda (pat) (minsup-eval-true pat db-cpt ms-n))
+                                  ws)))
+               ;; Resume from the patterns of the checkpoint, if any,
+               ;; and warm start from the previous patterns, if any
+               (previous (append (if resume?
+                                     (cog-outgoing-set
+                                      (cog-miner-load-checkpoint (Concept cf)))
+                                     '())
+                                 (if frontier?
+                                     (warm-start-frontier ws (get-initial-pattern)
+                                                          db-cpt ms-n mv
+                                                          enable-type enable-glob
+                                                          ignore-variables)
+                                     ws)))
+               (source (cond ((and frontier? (not resume?))
+                              (Set (map (lambda (pat) (minsup-eval-true pat db-cpt ms-n))
+                                        previous)))
+                             ((null? previous) initial-source)
+                             (else
+                              (Set initial-source
+                                   (map (lambda (pat) (minsup-eval-true pat db-cpt ms-n))
+                                        previous)))))
                (miner-rbs (random-miner-rbs-cpt))
-               (cfg-m (configure-miner miner-rbs
-                                       #:jobs jobs
-                                       #:maximum-iterations mi
-                                       #:complexity-penalty cp
-                                       #:conjunction-expansion ce
-                                       #:enforce-specialization es
-                                       #:maximum-conjuncts mc
-                                       #:maximum-variables mv
-                                       #:maximum-spcial-conjuncts mspc
-                                       #:maximum-cnjexp-variables mcev
-                                       #:enable-type enable-type
-                                       #:enable-glob enable-glob
-                                       #:ignore-variables ignore-variables))
+               (cfg-m (or native
+                          (configure-miner miner-rbs
+                                          #:jobs jobs
+                                          #:maximum-iterations mi
+                                          #:complexity-penalty cp
+                                          #:conjunction-expansion ce
+                                          #:enforce-specialization es
+                                          #:maximum-conjuncts mc
+                                          #:maximum-variables mv
+                                          #:maximum-spcial-conjuncts mspc
+                                          #:maximum-cnjexp-variables mcev
+                                          #:enable-type enable-type
+                                          #:enable-glob enable-glob
+                                          #:ignore-variables ignore-variables)))
 
                (dummy (miner-logger-debug "Initial pattern:\n~a" (get-initial-pattern)))
                (dummy (miner-logger-debug "Has enough support (min support = ~a)" ms))
-               (dummy (miner-logger-debug "Launch URE-based pattern mining"))
+               (dummy (miner-logger-debug (if native
+                                              "Launch C++ pattern mining"
+                                              "Launch URE-based pattern mining")))
 
                ;; Run pattern miner in a forward way
-               (results (cog-fc miner-rbs source))
-               ;; Fetch all relevant results
-               (patterns (fetch-patterns db-cpt ms-n))
-               (patterns-lst (cog-outgoing-set patterns)))
-
-          (if (equal? su 'none)
-
-              ;; No surprisingness, simple return the pattern list
-              (let* ((parent-patterns-lst (cog-cp parent-as patterns-lst)))
-                (miner-logger-debug "No surprisingness measure, end pattern miner now")
-                (cog-set-atomspace! parent-as)
-                parent-patterns-lst)
-
-              ;; Run surprisingness
-              (let*
-                  ;; Configure surprisingness backward chainer
-                  ((dummy (miner-logger-debug "Call surprisingness on mined patterns"))
-
-                   (surp-rbs (random-surprisingness-rbs-cpt))
-                   (target (surp-target su db-cpt))
-                   (vardecl (surp-vardecl))
-                   (cfg-s (configure-surprisingness surp-rbs su mc db-ratio))
-
-                   ;; Run surprisingness in a backward way
-                   (surp-res (cog-bc surp-rbs target #:vardecl vardecl))
-                   (surp-res-lst (cog-outgoing-set surp-res))
-                   (surp-res-sort-lst (desc-sort-by-tv-strength surp-res-lst))
-
-                   ;; Copy the results to the parent atomspace
-                   (parent-surp-res (cog-cp parent-as surp-res-sort-lst)))
-                (miner-logger-debug "End pattern miner")
-                (cog-set-atomspace! parent-as)
-                parent-surp-res))))))
+               (results (cond (native
+                               (cog-mine-cpp db-cpt ms-n (get-initial-pattern)
+                                             (native-options)))
+                              ((or budget? checkpoint? (< 0 tk))
+                               (fc-by-rounds miner-rbs source db-cpt ms-n
+                                             mi start-time tb mb tk
+                                             (if checkpoint?
+                                                 (checkpoint-saver cf ci db-cpt ms-n options)
+                                                 (lambda (patterns last?) #t))))
+                              (else (cog-fc miner-rbs source))))
+               ;; Final minimum support, raised by top-k
+               (ms-n (if (and (not native) (or budget? checkpoint? (< 0 tk)))
+                         results
+                         ms-n))
+               (out-of-budget (and budget?
+                                   (not (within-budget? start-time tb mb))))
+               ;; Fetch all relevant results, already filtered by the
+               ;; C++ miner according to om and tk
+               (all-patterns (if native results (fetch-patterns db-cpt ms-n)))
+               ;; Only retain patterns to output
+               (om-patterns-lst (if native
+                                    (cog-outgoing-set all-patterns)
+                                    (filter-output-mode om
+                                                        (cog-outgoing-set all-patterns)
+                                                        db-cpt ms-n)))
+               (patterns-lst (if (and (< 0 tk) (not native))
+                                 (filter-top-k tk om-patterns-lst db-cpt ms-n)
+                                 om-patterns-lst))
+               (patterns (if (or native (and (equal? om 'all) (<= tk 0)))
+                             all-patterns
+                             (Set patterns-lst))))
+
+          (cond
+            ((or (equal? su 'none) out-of-budget)
+             ;; No surprisingness, or no budget left for it, simply
+             ;; return the pattern list
+             (let* ((parent-patterns-lst (cog-cp parent-as patterns-lst)))
+               (miner-logger-debug "No surprisingness measure, end pattern miner now")
+               (end-mine parent-as)
+               parent-patterns-lst))
+
+            ((and (< 0 sk) (or (equal? su 'isurp) (equal? su 'nisurp)))
+             ;; Only calculate the empirical probabilities of patterns
+             ;; that may enter the top sk
+             (let* ((dummy (miner-logger-debug "Call top-~a surprisingness on mined patterns" sk))
+                    (isurp-top-k (if (equal? su 'isurp) cog-isurp-top-k cog-nisurp-top-k))
+                    (surp-res (isurp-top-k patterns db-cpt (Number sk) (Number db-ratio)))
+                    (parent-surp-res (cog-cp parent-as (cog-outgoing-set surp-res))))
+               (miner-logger-debug "End pattern miner")
+               (end-mine parent-as)
+               parent-surp-res))
+
+            (native
+             ;; Calculate surprisingness without the rule engine
+             (let* ((dummy (miner-logger-debug "Call native surprisingness on mined patterns"))
+                    (surp-res (cog-surp-top-k (Concept (symbol->string su))
+                                              patterns db-cpt
+                                              (Number (if (< 0 sk) sk (length patterns-lst)))
+                                              (Number db-ratio)))
+                    (parent-surp-res (cog-cp parent-as (cog-outgoing-set surp-res))))
+               (miner-logger-debug "End pattern miner")
+               (end-mine parent-as)
+               parent-surp-res))
+
+            (else
+             ;; Run surprisingness
+             (let*
+                 ;; Configure surprisingness backward chainer
+                 ((dummy (miner-logger-debug "Call surprisingness on mined patterns"))
+
+                  (surp-rbs (random-surprisingness-rbs-cpt))
+                  (target (surp-target su db-cpt))
+                  (vardecl (surp-vardecl))
+                  (cfg-s (configure-surprisingness surp-rbs su mc db-ratio))
+
+                  ;; Run surprisingness in a backward way
+                  (surp-res (cog-bc surp-rbs target #:vardecl vardecl))
+                  (surp-res-lst (cog-outgoing-set surp-res))
+                  (surp-res-sort-lst (desc-sort-by-tv-strength surp-res-lst))
+                  (surp-res-top-lst (if (and (< 0 sk) (< sk (length surp-res-sort-lst)))
+                                        (list-head surp-res-sort-lst sk)
+                                        surp-res-sort-lst))
+
+                  ;; Copy the results to the parent atomspace
+                  (parent-surp-res (cog-cp parent-as surp-res-top-lst)))
+               (miner-logger-debug "End pattern miner")
+               (end-mine parent-as)
+               parent-surp-res)))))))
+
+(define (cog-miner-convert-db scm-file db-file)
+"
+  Convert a db defined in Scheme into a db snapshot, a compact binary
+  file that can be loaded and mined without parsing Scheme.
+
+  Usage: (cog-miner-convert-db scm-file db-file)
+
+  scm-file: Scheme file defining the data trees, such as the knowledge
+            bases of the examples (once decompressed). All its atoms are
+            the data trees of the db, as when cog-mine is given an
+            atomspace.
+
+  db-file: Db snapshot file to write.
+
+  The snapshot can then be loaded as members of a db concept with
+  cog-miner-load-db, or mined natively without adding its data trees
+  to the atomspace with the snapshot option of cog-mine-cpp. From the
+  command line
+
+    guile -c '(use-modules (opencog) (opencog miner))
+              (cog-miner-convert-db \"kb.scm\" \"kb.mdb\")'
+"
+  (let* ((db-as (cog-new-atomspace))
+         (parent-as (cog-set-atomspace! db-as)))
+    (primitive-load scm-file)
+    ;; Fill the db concept in a temporary atomspace, to not add its
+    ;; member links to the db itself
+    (cog-set-atomspace! (cog-new-atomspace parent-as))
+    (cog-miner-save-db (Concept db-file)
+                       (fill-db-cpt (random-db-cpt) db-as))
+    (cog-set-atomspace! parent-as)
+    db-file))
+
+(define (cog-mine-native db . options)
+"
+  Like cog-mine but mine with the C++ miner and calculate surprisingness
+  natively, without the rule engine, taking the same keyword options.
+
+  Usage: (cog-mine-native db #:minsup ms ...)
+
+  Equivalent to (cog-mine db #:native #t #:minsup ms ...), see
+  (help cog-mine) for more info.
+"
+  (apply cog-mine db #:native #t options))
 
 ;;;;;;;;;;;;;;;;;;
 ;; Miner Logger ;;
@@ -1246,6 +1824,8 @@
     cog-miner-logger
     cog-miner
     cog-mine
+    cog-mine-native
+    cog-miner-convert-db
     ;; Functions to allow the rules to run
     shallow-specialization-mv-1-formula
     shallow-specialization-mv-2-formula